@@ -13,6 +13,9 @@ namespace NCL {
 
 		}
 
+		using CollisionVolume::operator new;
+		using CollisionVolume::operator delete;
+
 		Vector3 GetHalfDimensions() const {
 			return halfSizes;
 		}
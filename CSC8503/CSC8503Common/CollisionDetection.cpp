@@ -170,13 +170,6 @@ Vector3 CollisionDetection::Unproject(const Vector3& screenPos, const Camera& ca
 	//the order of matrices used to form it are inverted, too.
 	Matrix4 invVP = GenerateInverseView(cam) * GenerateInverseProjection(aspect, fov, nearPlane, farPlane);
 
-	Matrix4 test1 = GenerateInverseView(cam);
-	Matrix4 test2 = cam.BuildViewMatrix().Inverse();
-
-	Matrix4 proj  = cam.BuildProjectionMatrix(aspect);
-	Matrix4 test4 = cam.BuildProjectionMatrix(aspect).Inverse();
-	Matrix4 test3 = GenerateInverseProjection(aspect, fov, nearPlane, farPlane);
-
 	//Our mouse position x and y values are in 0 to screen dimensions range,
 	//so we need to turn them into the -1 to 1 axis range of clip space.
 	//We can do that by dividing the mouse values by the width and height of the
@@ -251,20 +244,12 @@ Matrix4 CollisionDetection::GenerateInverseProjection(float aspect, float fov, f
 }
 
 /*
-And here's how we generate an inverse view matrix. It's pretty much
-an exact inversion of the BuildViewMatrix function of the Camera class!
+And here's how we generate an inverse view matrix. A view matrix is only
+ever rotation and translation, so rather than a general inverse, the rotation
+can just be transposed, and the translation moved back the other way.
 */
 Matrix4 CollisionDetection::GenerateInverseView(const Camera &c) {
-	float pitch = c.GetPitch();
-	float yaw	= c.GetYaw();
-	Vector3 position = c.GetPosition();
-
-	Matrix4 iview =
-Matrix4::Translation(position) *
-Matrix4::Rotation(yaw, Vector3(0, 1, 0)) *
-Matrix4::Rotation(pitch, Vector3(1, 0, 0));
-
-return iview;
+	return c.BuildViewMatrix().RigidInverse();
 }
 
 
@@ -0,0 +1,35 @@
+#include "CollisionDetection.h"
+#include "CollisionVolume.h"
+#include "AABBVolume.h"
+#include "OBBVolume.h"
+#include "SphereVolume.h"
+#include "../../Common/ObjectPool.h"
+
+#include <type_traits>
+
+using namespace NCL;
+
+namespace {
+	typedef std::aligned_union<0, AABBVolume, OBBVolume, SphereVolume>::type VolumeSlot;
+
+	ObjectPool<VolumeSlot>& GetVolumePool() {
+		static ObjectPool<VolumeSlot> pool;
+		return pool;
+	}
+}
+
+void* CollisionVolume::operator new(size_t size) {
+	if (size > sizeof(VolumeSlot)) {
+		return ::operator new(size);
+	}
+	return GetVolumePool().Allocate();
+}
+
+void CollisionVolume::operator delete(void* p) {
+	if (GetVolumePool().Owns(p)) {
+		GetVolumePool().Free(p);
+	}
+	else {
+		::operator delete(p);
+	}
+}
\ No newline at end of file
@@ -1,4 +1,6 @@
 #pragma once
+#include <cstddef>
+
 namespace NCL {
 	enum class VolumeType {
 		AABB	= 1,
@@ -17,6 +19,12 @@ namespace NCL {
 		}
 		~CollisionVolume() {}
 
+		//Every kind of volume shares one pool, with slots that'll fit any of
+		//them - they're deleted through CollisionVolume pointers, so there's
+		//no telling which kind it was on the way back
+		static void* operator new(size_t size);
+		static void operator delete(void* p);
+
 		VolumeType type;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "ENetTransport.h"
+#include "SnapshotCompressor.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+ENetTransport* ENetTransport::Listen(int port, int maxPeers) {
+	ENetAddress address;
+	address.host = ENET_HOST_ANY;
+	address.port = port;
+
+	ENetHost* host = enet_host_create(&address, maxPeers, 1, 0, 0);
+	return host ? new ENetTransport(host) : nullptr;
+}
+
+ENetTransport* ENetTransport::CreateClient() {
+	ENetHost* host = enet_host_create(nullptr, 1, 1, 0, 0);
+	return host ? new ENetTransport(host) : nullptr;
+}
+
+ENetTransport::ENetTransport(ENetHost* h) {
+	host = h;
+}
+
+ENetTransport::~ENetTransport() {
+	enet_host_destroy(host);
+}
+
+int ENetTransport::Connect(const ENetAddress& address) {
+	ENetPeer* peer = enet_host_connect(host, &address, 2, 0);
+	return peer ? (int)peer->incomingPeerID : -1;
+}
+
+bool ENetTransport::Service(NetworkEvent& e, int timeoutMS) {
+	ENetEvent event;
+	if (enet_host_service(host, &event, timeoutMS) > 0) {
+		e.type		= event.type;
+		e.peerID	= event.peer->incomingPeerID;
+		e.packet	= event.packet;
+		return true;
+	}
+	return false;
+}
+
+void ENetTransport::Send(int peerID, ENetPacket* packet) {
+	if (peerID >= 0 && peerID < (int)host->peerCount) {
+		enet_peer_send(&host->peers[peerID], 0, packet); //if this fails, the packet's still unreferenced
+	}
+}
+
+void ENetTransport::Broadcast(ENetPacket* packet) {
+	enet_host_broadcast(host, 0, packet);
+}
+
+void ENetTransport::Flush() {
+	enet_host_flush(host);
+}
+
+bool ENetTransport::SetCompression(NetworkCompression mode) {
+	if (mode == NetworkCompression::RangeCoder) {
+		return enet_host_compress_with_range_coder(host) == 0;
+	}
+	if (mode == NetworkCompression::Snapshot) {
+		ENetCompressor compressor;
+		SnapshotCompressor::CreateENetCompressor(compressor);
+		enet_host_compress(host, &compressor);
+		return true;
+	}
+	enet_host_compress(host, nullptr);
+	return true;
+}
+
+bool ENetTransport::GetPeerStats(int peerID, TransportPeerStats& stats) const {
+	if (peerID < 0 || peerID >= (int)host->peerCount) {
+		return false;
+	}
+	const ENetPeer& peer = host->peers[peerID];
+	if (peer.state != ENET_PEER_STATE_CONNECTED) {
+		return false;
+	}
+	stats.roundTripTime		= (int)peer.roundTripTime;
+	stats.roundTripJitter	= (int)peer.roundTripTimeVariance;
+	stats.packetLoss		= peer.packetLoss / (float)ENET_PEER_PACKET_LOSS_SCALE;
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+#include "NetworkTransport.h"
+
+namespace NCL {
+	namespace CSC8503 {
+		//Real sockets - a thin wrapper around an ENetHost
+		class ENetTransport : public NetworkTransport	{
+		public:
+			//Both return nullptr if ENet couldn't create the host
+			static ENetTransport* Listen(int port, int maxPeers);
+			static ENetTransport* CreateClient();
+
+			~ENetTransport();
+
+			int  Connect(const ENetAddress& address) override;
+			bool Service(NetworkEvent& e, int timeoutMS) override;
+			void Send(int peerID, ENetPacket* packet) override;
+			void Broadcast(ENetPacket* packet) override;
+			void Flush() override;
+
+			bool SetCompression(NetworkCompression mode) override;
+
+			//Reads ENet's own figures, which the network thread might be halfway through updating
+			bool GetPeerStats(int peerID, TransportPeerStats& stats) const override;
+
+			int GetPeerCount() const override {
+				return (int)host->peerCount;
+			}
+
+		protected:
+			ENetTransport(ENetHost* host);
+
+			ENetHost* host;
+		};
+	}
+}
\ No newline at end of file
@@ -1,57 +1,90 @@
 #include "GameClient.h"
+#include "ENetTransport.h"
 #include <iostream>
 #include <string>
 
 using namespace NCL;
 using namespace CSC8503;
 
-GameClient::GameClient()	{
-	netHandle = enet_host_create(nullptr, 1, 1, 0, 0);
+GameClient::GameClient() : GameClient(ENetTransport::CreateClient()) {
+}
+
+GameClient::GameClient(NetworkTransport* t)	{
+	transport			= t;
+	serverPeerID		= -1;
+	lastFullSnapshot	= -1;
 }
 
 GameClient::~GameClient()	{
-	threadAlive = false;
-	updateThread.join();
-	enet_host_destroy(netHandle);
+	StopNetworkThread();
 }
 
 bool GameClient::Connect(uint8_t a, uint8_t b, uint8_t c, uint8_t d, int portNum) {
+	if (IsThreaded() || !transport) {
+		return false; //network thread owns the transport now
+	}
 	ENetAddress address;
 	address.port = portNum;
 	address.host = (d << 24 | (c << 16) | (b << 8) | (a));
 
-	netPeer = enet_host_connect(netHandle, &address, 2, 0);
+	serverPeerID = transport->Connect(address);
 
-	return netPeer != nullptr;
+	return serverPeerID >= 0;
 }
 
 void GameClient::UpdateClient() {
-	if (netHandle == nullptr) {
+	if (transport == nullptr) {
 		return;
 	}
 	//Handle all incoming packets
-	ENetEvent event;
-	while (enet_host_service(netHandle, &event, 0) > 0) {
+	NetworkEvent event;
+	while (GetNextEvent(event)) {
 		if (event.type == ENET_EVENT_TYPE_CONNECT) {
 			std::cout << "Connected to server!" << std::endl;
 		}
 		else if (event.type == ENET_EVENT_TYPE_RECEIVE) {
-			std::cout << "Client: Packet received..." << std::endl;
-			GamePacket* packet = (GamePacket*)event.packet->data;
-			ProcessPacket(packet);
+			PacketView view(event.packet->data, (int)event.packet->dataLength);
+			if (view.IsValid() && view.packet->type == BasicNetworkMessages::Snapshot_State) {
+				SnapshotPacket* header = view.As<SnapshotPacket>();
+				if (header) {
+					CountSnapshotPart(*header);
+				}
+			}
+			ProcessPacket(view);
+		}
+		if (event.packet) {
+			enet_packet_destroy(event.packet);
 		}
-		enet_packet_destroy(event.packet);
 	}
 }
 
 void GameClient::SendPacket(GamePacket&  payload) {
-	ENetPacket* dataPacket = enet_packet_create(&payload, payload.GetTotalSize(), 0);
-	enet_peer_send(netPeer, 0, dataPacket);
+	if (serverPeerID < 0) {
+		return;
+	}
+	ENetPacket* dataPacket = CreatePacket(payload);
+	SendToPeer(dataPacket, serverPeerID);
+	ReleasePacket(dataPacket);
 }
 
-void GameClient::ThreadedUpdate() {
-	while (threadAlive) {
-		UpdateClient();
-		std::this_thread::yield();
+const size_t MAX_PARTIAL_SNAPSHOTS = 8;
+
+/*
+Parts of a snapshot are sent unreliably, so any of them might go missing,
+and they needn't turn up in order, or might even turn up twice.
+*/
+void GameClient::CountSnapshotPart(const SnapshotPacket& header) {
+	if (!header.fullFrame || header.snapshotID <= lastFullSnapshot || header.part < 0 || header.part >= header.partCount) {
+		return;
 	}
-}
+	std::set<int>& parts = fullSnapshotParts[header.snapshotID];
+	parts.insert(header.part);
+	if ((int)parts.size() < header.partCount) {
+		if (fullSnapshotParts.size() > MAX_PARTIAL_SNAPSHOTS) {
+			fullSnapshotParts.erase(fullSnapshotParts.begin()); //that one's never going to be finished
+		}
+		return;
+	}
+	lastFullSnapshot = header.snapshotID;
+	fullSnapshotParts.erase(fullSnapshotParts.begin(), fullSnapshotParts.upper_bound(lastFullSnapshot));
+}
\ No newline at end of file
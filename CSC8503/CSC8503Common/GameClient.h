@@ -3,6 +3,8 @@
 #include <stdint.h>
 #include <thread>
 #include <atomic>
+#include <map>
+#include <set>
 
 namespace NCL {
 	namespace CSC8503 {
@@ -10,19 +12,27 @@ namespace NCL {
 		class GameClient : public NetworkBase {
 		public:
 			GameClient();
+			//Takes ownership of the transport - a LoopbackTransport for tests, say
+			GameClient(NetworkTransport* transport);
 			~GameClient();
 
 			bool Connect(uint8_t a, uint8_t b, uint8_t c, uint8_t d, int portNum);
 
 			void SendPacket(GamePacket&  payload);
 			void UpdateClient();
+
+			//The newest snapshot with full states in that's arrived in one piece - what to
+			//acknowledge. Every full frame has them, as can others. -1 if none has
+			int GetLastFullSnapshot() const {
+				return lastFullSnapshot;
+			}
 		protected:
+			void CountSnapshotPart(const SnapshotPacket& header);
 
-			void ThreadedUpdate();
+			int serverPeerID;	//-1 until Connect
 
-			ENetPeer*	netPeer;
-			std::atomic<bool>	threadAlive;
-			std::thread			updateThread;
+			int								lastFullSnapshot;
+			std::map<int, std::set<int>>	fullSnapshotParts;	//snapshotID -> parts arrived so far, for full frames newer than lastFullSnapshot
 		};
 	}
 }
@@ -1,6 +1,8 @@
 #include "GameObject.h"
 #include "CollisionDetection.h"
+#include "../../Common/MathsBatch.h"
 
+using namespace NCL;
 using namespace NCL::CSC8503;
 
 GameObject::GameObject(string objectName) {
@@ -19,6 +21,27 @@ GameObject::~GameObject() {
 	delete networkObject;
 }
 
+void* GameObject::operator new(size_t size) {
+	if (size != sizeof(GameObject)) {
+		return ::operator new(size);
+	}
+	return GetPool().Allocate();
+}
+
+void GameObject::operator delete(void* p) {
+	if (GetPool().Owns(p)) {
+		GetPool().Free(p);
+	}
+	else {
+		::operator delete(p);
+	}
+}
+
+ObjectPool<GameObject>& GameObject::GetPool() {
+	static ObjectPool<GameObject> pool;
+	return pool;
+}
+
 bool GameObject::InsideAABB(const Vector3& boxPos, const Vector3& halfSize) {
 	if (!boundingVolume) {
 		return false;
@@ -51,3 +74,35 @@ void GameObject::UpdateBroadphaseAABB() {
 		broadphaseAABB = mat * halfSizes;
 	}
 }
+
+const size_t AABB_BATCH_SIZE = 64; //small enough to live on the stack
+
+void GameObject::UpdateBroadphaseAABBs(GameObject* const* objects, size_t count) {
+	GameObject* boxes[AABB_BATCH_SIZE];
+	Quaternion	orientations[AABB_BATCH_SIZE];
+	Vector3		halfSizes[AABB_BATCH_SIZE];
+	Vector3		aabbs[AABB_BATCH_SIZE];
+
+	size_t boxCount = 0;
+	auto updateBoxes = [&]() {
+		Batch::OBBsToAABBs(orientations, halfSizes, aabbs, boxCount);
+		for (size_t i = 0; i < boxCount; ++i) {
+			boxes[i]->broadphaseAABB = aabbs[i];
+		}
+		boxCount = 0;
+	};
+	for (size_t i = 0; i < count; ++i) {
+		GameObject* o = objects[i];
+		if (!o->boundingVolume || o->boundingVolume->type != VolumeType::OBB) {
+			o->UpdateBroadphaseAABB(); //nothing to rotate
+			continue;
+		}
+		boxes[boxCount]			= o;
+		orientations[boxCount]	= o->transform.GetWorldOrientation();
+		halfSizes[boxCount]		= ((OBBVolume&)*o->boundingVolume).GetHalfDimensions();
+		if (++boxCount == AABB_BATCH_SIZE) {
+			updateBoxes();
+		}
+	}
+	updateBoxes();
+}
@@ -6,6 +6,8 @@
 #include "RenderObject.h"
 #include "NetworkObject.h"
 
+#include "../../Common/ObjectPool.h"
+
 #include <vector>
 
 using std::vector;
@@ -14,11 +16,38 @@ namespace NCL {
 	namespace CSC8503 {
 		class NetworkObject;
 
+		/*
+		GameObjects come from a pool (as do their render and physics objects,
+		and bounding volumes), so new and delete just recycle slots in it.
+		Subclasses are bigger than the pool's slots, so they still come from
+		the heap.
+		*/
 		class GameObject {
 		public:
+			typedef ObjectPool<GameObject>::Handle Handle;
+
 			GameObject(string name = "");
 			~GameObject();
 
+			//Main thread only, like the pools behind components and volumes
+			static void* operator new(size_t size);
+			static void operator delete(void* p);
+
+			static ObjectPool<GameObject>& GetPool();
+
+			//Unlike a pointer, a handle knows when its object's been deleted.
+			//Empty for subclasses, as they're not in the pool. Components and
+			//volumes go when their object does, so reach them through this
+			//rather than holding on to them
+			Handle GetHandle() const {
+				return GetPool().GetHandle(this);
+			}
+
+			//Null if it's been deleted since
+			static GameObject* FromHandle(const Handle& h) {
+				return GetPool().Get(h);
+			}
+
 			void SetBoundingVolume(CollisionVolume* vol) {
 				boundingVolume = vol;
 			}
@@ -58,6 +87,10 @@ namespace NCL {
 			void SetPhysicsObject(PhysicsObject* newObject) {
 				physicsObject = newObject;
 			}
+
+			void SetNetworkObject(NetworkObject* newObject) {
+				networkObject = newObject;
+			}
 			
 			const string& GetName() const {
 				return name;
@@ -80,6 +113,9 @@ namespace NCL {
 			bool GetBroadphaseAABB(Vector3& outsize) const;
 			void UpdateBroadphaseAABB();
 
+			//The same as UpdateBroadphaseAABB on each, but OBBs are done together, with Batch::OBBsToAABBs
+			static void UpdateBroadphaseAABBs(GameObject* const* objects, size_t count);
+
 		protected:
 			Transform			transform;
 
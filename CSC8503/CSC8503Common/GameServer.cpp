@@ -1,42 +1,68 @@
 #include "GameServer.h"
+#include "ENetTransport.h"
 #include "GameWorld.h"
+#include "GameObject.h"
+#include "NetworkObject.h"
+#include "QuadTree.h"
+#include <algorithm>
 #include <iostream>
 
 using namespace NCL;
 using namespace CSC8503;
 
-GameServer::GameServer(int onPort, int maxClients)	{
-	port		= onPort;
+GameServer::GameServer(int onPort, int maxClients) : GameServer(nullptr, maxClients) {
+	port = onPort;
+	Initialise();
+}
+
+GameServer::GameServer(NetworkTransport* t, int maxClients)	{
+	port		= -1;
 	clientMax	= maxClients;
 	clientCount = 0;
-	netHandle	= nullptr;
-	threadAlive = false;
+	transport	= t;
+	gameWorld	= nullptr;
+	snapshotID	= 0;
 
-	Initialise();
+	incomingDataRate = 0;
+	outgoingDataRate = 0;
+
+	relevancyRadius			= 0.0f;
+	relevancyBytesPerTick	= 0;
+	relevancyBounds			= Vector2(4096.0f, 4096.0f);
+	relevancyTree			= nullptr;
+
+	statsPeriod			= 1.0f;
+	statsTime			= 0.0f;
+	fullStatesWritten	= 0;
+	deltaStatesWritten	= 0;
+	largestSnapshot		= 0;
 }
 
 GameServer::~GameServer()	{
 	Shutdown();
+	delete relevancyTree;
 }
 
 void GameServer::Shutdown() {
+	if (!transport) {
+		return;
+	}
 	SendGlobalPacket(BasicNetworkMessages::Shutdown);
 
-	threadAlive = false;
-	updateThread.join();
+	StopNetworkThread();
+	transport->Flush();
 
-	enet_host_destroy(netHandle);
-	netHandle = nullptr;
+	delete transport;
+	transport = nullptr;
 }
 
 bool GameServer::Initialise() {
-	ENetAddress address;
-	address.host = ENET_HOST_ANY;
-	address.port = port;
-
-	netHandle = enet_host_create(&address, clientMax, 1, 0, 0);
+	if (transport) {
+		return true;
+	}
+	transport = ENetTransport::Listen(port, clientMax);
 
-	if (!netHandle) {
+	if (!transport) {
 		std::cout << "__FUNCTION__" << " failed to create network handle! " << std::endl;
 		return false;
 	}
@@ -50,39 +76,183 @@ bool GameServer::SendGlobalPacket(int msgID) {
 }
 
 bool GameServer::SendGlobalPacket(GamePacket& packet) {
-	ENetPacket* dataPacket = enet_packet_create(&packet, packet.GetTotalSize(), 0);
-	enet_host_broadcast(netHandle, 0, dataPacket);
+	if (!transport) {
+		return false;
+	}
+	SendToPeer(CreatePacket(packet), ALL_PEERS);
+	for (auto& i : peerTraffic) {
+		CountSent(i.first, packet.GetTotalSize());
+	}
+	return true;
+}
+
+bool GameServer::SendPeerPacket(int peerID, GamePacket& packet, bool reliable) {
+	if (!transport || peerID < 0 || peerID >= transport->GetPeerCount()) {
+		return false;
+	}
+	ENetPacket* dataPacket = CreatePacket(packet, reliable ? ENET_PACKET_FLAG_RELIABLE : 0);
+	SendToPeer(dataPacket, peerID);
+	ReleasePacket(dataPacket);
+	CountSent(peerID, packet.GetTotalSize());
 	return true;
 }
 
 void GameServer::UpdateServer() {
-	if (!netHandle) { return; }
-	ENetEvent event; 
-	while (enet_host_service(netHandle, &event, 0) > 0) {
+	if (!transport) { return; }
+	NetworkEvent event;
+	while (GetNextEvent(event)) {
 		int type = event.type;
-		ENetPeer*p =event.peer;
-		int peer = p->incomingPeerID;
+		int peer = event.peerID;
 
 		if (type == ENetEventType::ENET_EVENT_TYPE_CONNECT) {
 			std::cout << "Server: New client connected" << std::endl;
+			stateIDs[peer]		= -1;
+			peerTraffic[peer]	= PeerTraffic();
+
+			if (HasPacketHandlers(BasicNetworkMessages::Player_Connected)) {
+				NewPlayerPacket player(peer);
+				ProcessPacket(&player, peer);
+			}
 		}
 		else if (type == ENetEventType::ENET_EVENT_TYPE_DISCONNECT) {
 			std::cout << "Server: A client has disconnected" << std::endl;
+			stateIDs.erase(peer);
+			clientRelevancy.erase(peer);
+			peerTraffic.erase(peer);
+			peerStats.erase(peer);
+
+			if (HasPacketHandlers(BasicNetworkMessages::Player_Disconnected)) {
+				PlayerDisconnectPacket player(peer);
+				ProcessPacket(&player, peer);
+			}
 		}
 		else if (type == ENetEventType::ENET_EVENT_TYPE_RECEIVE) {
-			GamePacket* packet = (GamePacket*)event.packet->data;
-			ProcessPacket(packet, peer);
+			PacketView view(event.packet->data, (int)event.packet->dataLength);
+			CountReceived(peer, view.length);
+
+			if (!view.IsValid()) {
+				auto t = peerTraffic.find(peer);
+				if (t != peerTraffic.end()) {
+					t->second.badPackets++;
+				}
+				ProcessPacket(view, peer);
+			}
+			else if (view.packet->type == BasicNetworkMessages::Received_State) {
+				ClientPacket* ack = view.As<ClientPacket>();
+				auto i = stateIDs.find(peer);
+				if (ack && i != stateIDs.end()) {
+					if (ack->lastID > i->second) {
+						i->second = ack->lastID;
+					}
+					else if (ack->lastID < i->second) {
+						peerTraffic[peer].latePackets++;
+					}
+				}
+				if (HasPacketHandlers(view.packet->type)) {
+					ProcessPacket(view, peer); //game might want the button states
+				}
+			}
+			else {
+				ProcessPacket(view, peer);
+			}
+		}
+		if (event.packet) {
+			enet_packet_destroy(event.packet);
+		}
+	}
+}
+
+void GameServer::CountSent(int peerID, int bytes) {
+	auto i = peerTraffic.find(peerID);
+	if (i != peerTraffic.end()) {
+		i->second.bytesOut += bytes;
+		i->second.packetsOut++;
+	}
+}
+
+void GameServer::CountSnapshot(int peerID, int bytes) {
+	if (bytes == 0) {
+		return; //nothing changed, so nothing was sent
+	}
+	auto i = peerTraffic.find(peerID);
+	if (i != peerTraffic.end()) {
+		i->second.snapshots++;
+		i->second.snapshotBytes += bytes;
+	}
+	largestSnapshot = std::max(largestSnapshot, bytes);
+}
+
+void GameServer::CountReceived(int peerID, int bytes) {
+	auto i = peerTraffic.find(peerID);
+	if (i != peerTraffic.end()) {
+		i->second.bytesIn += bytes;
+		i->second.packetsIn++;
+	}
+}
+
+void GameServer::UpdateStats(float dt) {
+	statsTime += dt;
+	if (statsTime < statsPeriod || statsTime <= 0.0f) {
+		return;
+	}
+	serverStats = NetworkServerStats();
+	peerStats.clear();
+
+	int totalSnapshots		= 0;
+	int totalSnapshotBytes	= 0;
+
+	for (auto& i : peerTraffic) {
+		const PeerTraffic&	t		= i.second;
+		NetworkPeerStats&	stats	= peerStats[i.first];
+
+		stats.bytesIn		= t.bytesIn / statsTime;
+		stats.bytesOut		= t.bytesOut / statsTime;
+		stats.packetsIn		= t.packetsIn / statsTime;
+		stats.packetsOut	= t.packetsOut / statsTime;
+		stats.snapshotBytes = t.snapshots > 0 ? t.snapshotBytes / (float)t.snapshots : 0.0f;
+		stats.latePackets	= t.latePackets / statsTime;
+		stats.badPackets	= t.badPackets / statsTime;
+
+		TransportPeerStats link;
+		if (GetLinkStats(i.first, link)) {
+			stats.roundTripTime		= link.roundTripTime;
+			stats.roundTripJitter	= link.roundTripJitter;
+			stats.packetLoss		= link.packetLoss;
 		}
-		enet_packet_destroy(event.packet);
+		serverStats.peerCount++;
+		serverStats.bytesIn		+= stats.bytesIn;
+		serverStats.bytesOut	+= stats.bytesOut;
+		serverStats.packetsIn	+= stats.packetsIn;
+		serverStats.packetsOut	+= stats.packetsOut;
+		serverStats.latePackets += stats.latePackets;
+		serverStats.badPackets	+= stats.badPackets;
+
+		totalSnapshots		+= t.snapshots;
+		totalSnapshotBytes	+= t.snapshotBytes;
+
+		i.second = PeerTraffic();
 	}
+	serverStats.snapshotBytes	= totalSnapshots > 0 ? totalSnapshotBytes / (float)totalSnapshots : 0.0f;
+	serverStats.largestSnapshot = largestSnapshot;
+	serverStats.fullStates		= fullStatesWritten / statsTime;
+	serverStats.deltaStates		= deltaStatesWritten / statsTime;
 
+	incomingDataRate = (int)serverStats.bytesIn;
+	outgoingDataRate = (int)serverStats.bytesOut;
+
+	statsTime			= 0.0f;
+	fullStatesWritten	= 0;
+	deltaStatesWritten	= 0;
+	largestSnapshot		= 0;
 }
 
-void GameServer::ThreadedUpdate() {
-	while (threadAlive) {
-		UpdateServer();
-		std::this_thread::yield();
+bool GameServer::GetPeerStats(int peerID, NetworkPeerStats& stats) const {
+	auto i = peerStats.find(peerID);
+	if (i == peerStats.end()) {
+		return false;
 	}
+	stats = i->second;
+	return true;
 }
 
 //Second networking tutorial stuff
@@ -91,10 +261,319 @@ void GameServer::SetGameWorld(GameWorld &g) {
 	gameWorld = &g;
 }
 
+/*
+Leave room for the ENet, UDP and IP headers, so that a whole snapshot packet
+fits inside the default ENet MTU and never has to be fragmented.
+*/
+const int SNAPSHOT_MAX_BYTES = ENET_HOST_DEFAULT_MTU - 100;
+
+const float	MIN_RELEVANT_PRIORITY	= 0.1f;	//even the furthest relevant objects get sent eventually
+const int	MAX_UNACKNOWLEDGED		= 16;	//snapshots with full states in, waiting to hear if they arrived
+const float	RELEVANCY_TREE_SLACK	= 0.25f;	//how far objects can move before the tree's rebuilt, as a fraction of the radius
+
+void GameServer::SetRelevancy(float radius, int bytesPerTick) {
+	relevancyRadius			= radius;
+	relevancyBytesPerTick	= bytesPerTick;
+}
+
+void GameServer::SetClientFocus(int peerID, GameObject* focus) {
+	clientRelevancy[peerID].focus = focus;
+}
+
 void GameServer::BroadcastSnapshot(bool deltaFrame) {
+	if (!transport || !gameWorld) {
+		return;
+	}
+	snapshotID++;
+
+	std::vector<GameObject*>::const_iterator first;
+	std::vector<GameObject*>::const_iterator last;
+	gameWorld->GetObjectIterators(first, last);
+
+	std::vector<NetworkObject*> networkObjects;
+	for (auto i = first; i != last; ++i) {
+		NetworkObject* o = (*i)->GetNetworkObject();
+		if (o) {
+			o->RecordState(snapshotID);
+			networkObjects.emplace_back(o);
+		}
+	}
+	if (relevancyRadius <= 0.0f && relevancyBytesPerTick <= 0) {
+		//Everyone gets everything, so clients that have acknowledged the same state get sent the same packets
+		std::map<int, std::vector<ENetPacket*>> packetsByState;
+
+		for (auto& client : stateIDs) {
+			int baseState = deltaFrame ? client.second : -1;
+
+			auto found = packetsByState.find(baseState);
+			if (found == packetsByState.end()) {
+				found = packetsByState.insert(std::make_pair(baseState, std::vector<ENetPacket*>())).first;
+				BuildSnapshot(baseState >= 0, baseState, found->second);
+			}
+			int snapshotBytes = 0;
+			for (ENetPacket* p : found->second) {
+				SendToPeer(p, client.first);
+				CountSent(client.first, (int)p->dataLength);
+				snapshotBytes += (int)p->dataLength;
+			}
+			CountSnapshot(client.first, snapshotBytes);
+		}
+		for (auto& i : packetsByState) {
+			for (ENetPacket* p : i.second) {
+				ReleasePacket(p);
+			}
+		}
+		UpdateMinimumState();
+		return;
+	}
+	if (relevancyRadius > 0.0f) {
+		UpdateRelevancyTree(networkObjects);
+	}
+	for (auto& client : stateIDs) {
+		ClientRelevancy& relevancy = clientRelevancy[client.first];
+
+		std::vector<NetworkObject*> relevant;
+		if (relevancyRadius > 0.0f && relevancy.focus) {
+			Vector3 centre		= relevancy.focus->GetTransform().GetWorldPosition();
+			float	radiusSq	= relevancyRadius * relevancyRadius;
+			float	queryRadius	= relevancyRadius * (1.0f + RELEVANCY_TREE_SLACK);
+
+			relevancyTree->OperateOnRegion(centre, Vector3(queryRadius, queryRadius, queryRadius),
+				[&](QuadTree<NetworkObject*>::EntryList& data) {
+				for (auto& i : data) {
+					Vector3 offset = i.object->GetLatestNetworkState().position - centre; //not i.pos, it might have moved since
+					if (Vector3::Dot(offset, offset) <= radiusSq) {
+						relevant.emplace_back(i.object);
+					}
+				}
+			});
+			std::sort(relevant.begin(), relevant.end()); //might have come from more than one leaf
+			relevant.erase(std::unique(relevant.begin(), relevant.end()), relevant.end());
+			relevant.insert(relevant.end(), alwaysRelevant.begin(), alwaysRelevant.end());
+		}
+		else {
+			relevant = networkObjects;
+		}
+		std::vector<ENetPacket*> packets;
+		BuildClientSnapshot(deltaFrame, client.second, relevancy, relevant, packets);
+
+		int snapshotBytes = 0;
+		for (ENetPacket* p : packets) {
+			SendToPeer(p, client.first);
+			CountSent(client.first, (int)p->dataLength);
+			snapshotBytes += (int)p->dataLength;
+			ReleasePacket(p);
+		}
+		CountSnapshot(client.first, snapshotBytes);
+	}
+	UpdateMinimumState();
+}
+
+void GameServer::BuildSnapshot(bool deltaFrame, int stateID, std::vector<ENetPacket*>& packets) {
+	std::vector<GameObject*>::const_iterator first;
+	std::vector<GameObject*>::const_iterator last;
+	gameWorld->GetObjectIterators(first, last);
+
+	std::vector<char> buffer;
+	buffer.reserve(SNAPSHOT_MAX_BYTES);
+
+	for (auto i = first; i != last; ++i) {
+		NetworkObject* o = (*i)->GetNetworkObject();
+		if (!o) {
+			continue;
+		}
+		GamePacket* newPacket = nullptr;
+		if (o->WritePacket(&newPacket, deltaFrame, stateID) && newPacket) {
+			AddToSnapshot(newPacket, buffer, packets);
+		}
+		delete newPacket;
+	}
+	FlushSnapshot(buffer, packets);
+	SetSnapshotParts(packets, !deltaFrame); //everything deltas against the last full frame
+}
+
+/*
+Everything networked moves a little every tick, so building a new tree for
+each broadcast would mostly be wasted effort. Instead, the tree's kept until
+something has moved further than the slack from where it was inserted, and
+queries are widened by the slack to make up for it - it's the objects' real
+positions that are tested against the radius, not the ones in the tree.
+*/
+void GameServer::UpdateRelevancyTree(const std::vector<NetworkObject*>& networkObjects) {
+	float slackSq	= relevancyRadius * RELEVANCY_TREE_SLACK * relevancyRadius * RELEVANCY_TREE_SLACK;
+	bool rebuild	= !relevancyTree || networkObjects != treeObjects;
+
+	for (size_t i = 0; i < networkObjects.size() && !rebuild; ++i) {
+		Vector3 offset = networkObjects[i]->GetLatestNetworkState().position - treePositions[i];
+		rebuild = Vector3::Dot(offset, offset) > slackSq;
+	}
+	if (!rebuild) {
+		return;
+	}
+	delete relevancyTree;
+	relevancyTree = new QuadTree<NetworkObject*>(relevancyBounds, 7, 5);
+
+	treeObjects = networkObjects;
+	treePositions.clear();
+	alwaysRelevant.clear();
+
+	for (NetworkObject* o : networkObjects) {
+		Vector3 pos = o->GetLatestNetworkState().position;
+		treePositions.emplace_back(pos);
+		if (fabs(pos.x) < relevancyBounds.x && fabs(pos.z) < relevancyBounds.y) {
+			relevancyTree->Insert(o, pos, Vector3(1, 1, 1)); //not zero, or it's lost if it sits exactly on a split
+		}
+		else {
+			alwaysRelevant.emplace_back(o);
+		}
+	}
+}
+
+/*
+Clients only see some of the objects in each snapshot, and the byte budget
+can leave out even relevant ones, so there's no one snapshot that every
+delta can be against. Instead, each object is sent as a delta against the
+newest full state of it the client is known to have - one that went out in
+a snapshot the client has since acknowledged. Full states can go out on any
+frame, so any snapshot with one in asks to be acknowledged.
+*/
+void GameServer::BuildClientSnapshot(bool deltaFrame, int stateID, ClientRelevancy& client,
+	const std::vector<NetworkObject*>& relevant, std::vector<ENetPacket*>& packets) {
+	bool fullFrame = !deltaFrame || stateID < 0;
+
+	bool	hasFocus	= relevancyRadius > 0.0f && client.focus;
+	Vector3 centre		= hasFocus ? client.focus->GetTransform().GetWorldPosition() : Vector3();
+
+	std::vector<std::pair<float, NetworkObject*>> sendOrder;
+	sendOrder.reserve(relevant.size());
+
+	for (NetworkObject* o : relevant) {
+		float weight = 1.0f;
+		if (hasFocus) {
+			float distance = (o->GetLatestNetworkState().position - centre).Length();
+			weight = std::max(MIN_RELEVANT_PRIORITY, 1.0f - (distance / relevancyRadius));
+		}
+		float& priority = client.priorities[o->GetNetworkID()];
+		priority += weight;
+		sendOrder.emplace_back(priority, o);
+	}
+	std::sort(sendOrder.begin(), sendOrder.end(),
+		[](const std::pair<float, NetworkObject*>& a, const std::pair<float, NetworkObject*>& b) {
+		return a.first > b.first;
+	});
+
+	auto acknowledged = client.fullStatesSent.find(stateID);
+	if (acknowledged != client.fullStatesSent.end()) {
+		for (int id : acknowledged->second) {
+			client.deltaBases[id] = stateID;
+		}
+	}
+	//Anything older has either been acknowledged, or never will be
+	client.fullStatesSent.erase(client.fullStatesSent.begin(), client.fullStatesSent.upper_bound(stateID));
+	std::set<int> sentFull;
 
+	std::vector<char> buffer;
+	buffer.reserve(SNAPSHOT_MAX_BYTES);
+	int bytesSent = 0;
+
+	for (auto& i : sendOrder) {
+		if (relevancyBytesPerTick > 0 && bytesSent >= relevancyBytesPerTick) {
+			break; //everything else keeps its priority for next time
+		}
+		NetworkObject*	o	= i.second;
+		int				id	= o->GetNetworkID();
+
+		auto base		= client.deltaBases.find(id);
+		bool canDelta	= !fullFrame && base != client.deltaBases.end();
+
+		GamePacket* newPacket = nullptr;
+		if (o->WritePacket(&newPacket, canDelta, canDelta ? base->second : -1) && newPacket) {
+			bytesSent += newPacket->GetTotalSize();
+			AddToSnapshot(newPacket, buffer, packets);
+
+			if (newPacket->type == BasicNetworkMessages::Full_State) {
+				sentFull.insert(id); //whether it's a full frame or not
+			}
+		}
+		delete newPacket;
+		client.priorities[id] = 0.0f;
+	}
+	FlushSnapshot(buffer, packets);
+	SetSnapshotParts(packets, !sentFull.empty());
+
+	if (!sentFull.empty()) {
+		client.fullStatesSent[snapshotID] = std::move(sentFull);
+		if ((int)client.fullStatesSent.size() > MAX_UNACKNOWLEDGED) {
+			client.fullStatesSent.erase(client.fullStatesSent.begin()); //they'll just get sent again
+		}
+	}
+}
+
+void GameServer::AddToSnapshot(GamePacket* packet, std::vector<char>& buffer, std::vector<ENetPacket*>& packets) {
+	int packetSize = packet->GetTotalSize();
+
+	if (!buffer.empty() && buffer.size() + packetSize > SNAPSHOT_MAX_BYTES) {
+		FlushSnapshot(buffer, packets);
+	}
+	if (buffer.empty()) {
+		SnapshotPacket header(snapshotID);
+		buffer.insert(buffer.end(), (char*)&header, (char*)&header + sizeof(header));
+	}
+	buffer.insert(buffer.end(), (char*)packet, (char*)packet + packetSize);
+
+	if (packet->type == BasicNetworkMessages::Full_State) {
+		fullStatesWritten++;
+	}
+	else {
+		deltaStatesWritten++;
+	}
+}
+
+void GameServer::FlushSnapshot(std::vector<char>& buffer, std::vector<ENetPacket*>& packets) {
+	if (buffer.empty()) {
+		return;
+	}
+	SnapshotPacket* header = (SnapshotPacket*)buffer.data();
+	header->size = (short)(buffer.size() - sizeof(GamePacket));
+
+	packets.emplace_back(packetPool.CreatePacket(buffer.data(), buffer.size()));
+	buffer.clear();
+}
+
+//Only known once the whole snapshot's been split up
+void GameServer::SetSnapshotParts(std::vector<ENetPacket*>& packets, bool acknowledge) {
+	for (size_t i = 0; i < packets.size(); ++i) {
+		SnapshotPacket* header = (SnapshotPacket*)packets[i]->data;
+		header->fullFrame	= acknowledge ? 1 : 0;
+		header->part		= (short)i;
+		header->partCount	= (short)packets.size();
+	}
 }
 
+//Objects only need to remember states that some client might still delta against
 void GameServer::UpdateMinimumState() {
+	if (!gameWorld) {
+		return;
+	}
+	int minID = snapshotID;
+	for (auto& client : stateIDs) {
+		if (client.second >= 0 && client.second < minID) {
+			minID = client.second;
+		}
+	}
+	for (auto& client : clientRelevancy) { //objects can delta against older states than the snapshot acknowledged
+		for (auto& base : client.second.deltaBases) {
+			minID = std::min(minID, base.second);
+		}
+	}
+	std::vector<GameObject*>::const_iterator first;
+	std::vector<GameObject*>::const_iterator last;
+	gameWorld->GetObjectIterators(first, last);
 
+	for (auto i = first; i != last; ++i) {
+		NetworkObject* o = (*i)->GetNetworkObject();
+		if (o) {
+			o->UpdateStateHistory(minID);
+		}
+	}
 }
\ No newline at end of file
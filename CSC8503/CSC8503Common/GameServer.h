@@ -1,15 +1,87 @@
 #pragma once
 #include <thread>
 #include <atomic>
+#include <set>
+#include <vector>
 
 #include "NetworkBase.h"
+#include "../../Common/Vector2.h"
+#include "../../Common/Vector3.h"
 
 namespace NCL {
+	using namespace NCL::Maths;
 	namespace CSC8503 {
 		class GameWorld;
+		class GameObject;
+		class NetworkObject;
+		template<class T> class QuadTree;
+
+		/*
+		Traffic is only what the game sent and received - ENet, UDP and IP
+		headers aren't counted. Everything's per second, averaged over the
+		last stats period (see GameServer::UpdateStats).
+		*/
+		struct NetworkPeerStats {
+			float	bytesIn;
+			float	bytesOut;
+			float	packetsIn;
+			float	packetsOut;
+			float	snapshotBytes;	//average size of one of this peer's snapshots
+			float	latePackets;	//acks older than one that had already arrived
+			float	badPackets;		//failed validation, and were thrown away
+
+			int		roundTripTime;	//from the transport, in ms
+			int		roundTripJitter;
+			float	packetLoss;		//0 to 1
+
+			NetworkPeerStats() {
+				bytesIn			= 0.0f;
+				bytesOut		= 0.0f;
+				packetsIn		= 0.0f;
+				packetsOut		= 0.0f;
+				snapshotBytes	= 0.0f;
+				latePackets		= 0.0f;
+				badPackets		= 0.0f;
+				roundTripTime	= 0;
+				roundTripJitter = 0;
+				packetLoss		= 0.0f;
+			}
+		};
+
+		//The same, but for every peer put together
+		struct NetworkServerStats {
+			int		peerCount;
+			float	bytesIn;
+			float	bytesOut;
+			float	packetsIn;
+			float	packetsOut;
+			float	snapshotBytes;		//average over every peer's snapshots
+			int		largestSnapshot;	//in bytes, over the last period
+			float	fullStates;			//object states written into snapshots
+			float	deltaStates;
+			float	latePackets;
+			float	badPackets;
+
+			NetworkServerStats() {
+				peerCount		= 0;
+				bytesIn			= 0.0f;
+				bytesOut		= 0.0f;
+				packetsIn		= 0.0f;
+				packetsOut		= 0.0f;
+				snapshotBytes	= 0.0f;
+				largestSnapshot = 0;
+				fullStates		= 0.0f;
+				deltaStates		= 0.0f;
+				latePackets		= 0.0f;
+				badPackets		= 0.0f;
+			}
+		};
+
 		class GameServer : public NetworkBase {
 		public:
 			GameServer(int onPort, int maxClients);
+			//Takes ownership of the transport - a LoopbackTransport for tests, say
+			GameServer(NetworkTransport* transport, int maxClients);
 			~GameServer();
 
 			bool Initialise();
@@ -17,30 +89,139 @@ namespace NCL {
 
 			void SetGameWorld(GameWorld &g);
 
-			void ThreadedUpdate();
-
 			bool SendGlobalPacket(int msgID);
 			bool SendGlobalPacket(GamePacket& packet);
+			bool SendPeerPacket(int peerID, GamePacket& packet, bool reliable = false);
 
+			//Sends every NetworkObject's state to every client, batched into as few
+			//packets as possible. Delta frames are against each client's last
+			//acknowledged full snapshot, and clients with nothing acknowledged get
+			//full states instead
 			void BroadcastSnapshot(bool deltaFrame);
 			void UpdateMinimumState();
+			//Connections and disconnections are passed on to any Player_Connected /
+			//Player_Disconnected handlers, as a NewPlayerPacket / PlayerDisconnectPacket
 			virtual void UpdateServer();
+
+			int GetSnapshotID() const {
+				return snapshotID;
+			}
+
+			/*
+			Interest management - once a client has a focus object (their ball,
+			say), they only get told about objects within radius of it. Each
+			tick, every relevant object builds up priority (more the closer it
+			is), and clients are sent the highest priority objects first until
+			they've had bytesPerTick. Zero turns off either part.
+			*/
+			void SetRelevancy(float radius, int bytesPerTick);
+			void SetClientFocus(int peerID, GameObject* focus);
+
+			//Counters build up between calls, and are turned into the stats once a period has passed
+			void UpdateStats(float dt);
+
+			void SetStatsPeriod(float seconds) {
+				statsPeriod = seconds;
+			}
+
+			const NetworkServerStats& GetStats() const {
+				return serverStats;
+			}
+
+			//False if the peer hasn't been connected for a whole period yet
+			bool GetPeerStats(int peerID, NetworkPeerStats& stats) const;
+
+			//Bytes per second, all peers together
+			int GetIncomingDataRate() const {
+				return incomingDataRate;
+			}
+
+			int GetOutgoingDataRate() const {
+				return outgoingDataRate;
+			}
+
+			//Objects outside this XZ area around the origin are always relevant
+			void SetRelevancyBounds(const Vector2& halfSize) {
+				relevancyBounds = halfSize;
+				treeObjects.clear(); //so the tree's rebuilt with the new bounds
+			}
 		protected:
+			struct ClientRelevancy {
+				GameObject*						focus;
+				std::map<int, float>			priorities;			//networkID -> accumulated priority
+				std::map<int, std::set<int>>	fullStatesSent;		//snapshotID -> networkIDs sent as full states in it, until it's acknowledged
+				std::map<int, int>				deltaBases;			//networkID -> newest acknowledged snapshot with its full state in
+
+				ClientRelevancy() {
+					focus = nullptr;
+				}
+			};
+
+			//Counted up for each peer over the current stats period
+			struct PeerTraffic {
+				int bytesIn;
+				int bytesOut;
+				int packetsIn;
+				int packetsOut;
+				int snapshots;
+				int snapshotBytes;
+				int latePackets;
+				int badPackets;
+
+				PeerTraffic() {
+					bytesIn			= 0;
+					bytesOut		= 0;
+					packetsIn		= 0;
+					packetsOut		= 0;
+					snapshots		= 0;
+					snapshotBytes	= 0;
+					latePackets		= 0;
+					badPackets		= 0;
+				}
+			};
+
+			void CountSent(int peerID, int bytes);
+			void CountSnapshot(int peerID, int bytes);
+			void CountReceived(int peerID, int bytes);
+
+			void BuildSnapshot(bool deltaFrame, int stateID, std::vector<ENetPacket*>& packets);
+			void BuildClientSnapshot(bool deltaFrame, int stateID, ClientRelevancy& client,
+				const std::vector<NetworkObject*>& relevant, std::vector<ENetPacket*>& packets);
+			void AddToSnapshot(GamePacket* packet, std::vector<char>& buffer, std::vector<ENetPacket*>& packets);
+			void FlushSnapshot(std::vector<char>& buffer, std::vector<ENetPacket*>& packets);
+			void SetSnapshotParts(std::vector<ENetPacket*>& packets, bool acknowledge);
+			void UpdateRelevancyTree(const std::vector<NetworkObject*>& networkObjects);
+
 			int			port;
 			int			clientMax;
 			int			clientCount;
 			GameWorld*	gameWorld;
 
-			std::atomic<bool> threadAlive;
+			int incomingDataRate;
+			int outgoingDataRate;
 
+			int snapshotID;
+			std::map<int, int> stateIDs;	//peer -> last full snapshot they've acknowledged, -1 if none
 
+			std::map<int, ClientRelevancy> clientRelevancy;
+			float	relevancyRadius;
+			int		relevancyBytesPerTick;
+			Vector2 relevancyBounds;
 
-			std::thread updateThread;
+			QuadTree<NetworkObject*>*	relevancyTree;	//kept between ticks, see UpdateRelevancyTree
+			std::vector<NetworkObject*>	treeObjects;	//what relevancyTree was built from
+			std::vector<Vector3>		treePositions;	//and where each of them was at the time
+			std::vector<NetworkObject*>	alwaysRelevant;	//outside relevancyBounds when the tree was built
 
-			int incomingDataRate;
-			int outgoingDataRate;
+			std::map<int, PeerTraffic>		peerTraffic;
+			std::map<int, NetworkPeerStats> peerStats;
+			NetworkServerStats				serverStats;
 
-			std::map<int, int> stateIDs;
+			float	statsPeriod;
+			float	statsTime;
+			int		fullStatesWritten;
+			int		deltaStatesWritten;
+			int		largestSnapshot;
 		};
 	}
 }
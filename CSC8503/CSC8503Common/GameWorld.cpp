@@ -2,7 +2,9 @@
 #include "GameObject.h"
 #include "CollisionDetection.h"
 #include "../../Common/Camera.h"
+#include "../../Common/JobSystem.h"
 #include <algorithm>
+#include <unordered_set>
 
 using namespace NCL;
 using namespace NCL::CSC8503;
@@ -14,6 +16,12 @@ GameWorld::GameWorld()	{
 
 	shuffleConstraints	= false;
 	shuffleObjects		= false;
+
+	transformOrderVersion	= 0;
+	transformOrderDirty		= true;
+
+	jobSystem					= nullptr;
+	parallelTransformThreshold	= 1024;
 }
 
 GameWorld::~GameWorld()	{
@@ -22,6 +30,9 @@ GameWorld::~GameWorld()	{
 void GameWorld::Clear() {
 	gameObjects.clear();
 	constraints.clear();
+	transformOrder.clear();
+	transformLevels.clear();
+	transformOrderDirty = true;
 }
 
 void GameWorld::ClearAndErase() {
@@ -36,10 +47,12 @@ void GameWorld::ClearAndErase() {
 
 void GameWorld::AddGameObject(GameObject* o) {
 	gameObjects.emplace_back(o);
+	transformOrderDirty = true;
 }
 
 void GameWorld::RemoveGameObject(GameObject* o) {
-	std::remove(gameObjects.begin(), gameObjects.end(), o);
+	gameObjects.erase(std::remove(gameObjects.begin(), gameObjects.end(), o), gameObjects.end());
+	transformOrderDirty = true;
 }
 
 void GameWorld::GetObjectIterators(
@@ -64,9 +77,69 @@ void GameWorld::UpdateWorld(float dt) {
 
 
 void GameWorld::UpdateTransforms() {
+	if (transformOrderDirty || transformOrderVersion != Transform::GetHierarchyVersion()) {
+		SortTransforms();
+	}
+	//Everything at one depth only reads from the level above, so each level
+	//can be split up between threads, as long as they're done in order
+	for (size_t level = 0; level + 1 < transformLevels.size(); ++level) {
+		Transform** first	= &transformOrder[0] + transformLevels[level];
+		size_t count		= transformLevels[level + 1] - transformLevels[level];
+
+		auto updateRange = [first](size_t from, size_t to) {
+			for (size_t i = from; i < to; ++i) {
+				first[i]->UpdateMatrices(); //only does anything if it, or a parent, has changed
+			}
+		};
+		if (count < parallelTransformThreshold) {
+			updateRange(0, count);
+		}
+		else {
+			JobSystem& jobs = jobSystem ? *jobSystem : JobSystem::GetShared();
+			jobs.ParallelFor(count, 256, updateRange);
+		}
+	}
+}
+
+/*
+Only needed when objects come and go, or are reparented. Ordering by depth
+gets every parent updated before any of its children, without having to
+walk the hierarchy every frame.
+
+Parents that aren't in the world themselves are put in the order too, at
+their own depth - otherwise siblings on different threads could all try
+to update the same dirty parent at once.
+*/
+void GameWorld::SortTransforms() {
+	std::vector<std::pair<int, Transform*>> byDepth;
+	byDepth.reserve(gameObjects.size());
+	std::unordered_set<const Transform*> ordered;
+	for (auto& i : gameObjects) {
+		byDepth.emplace_back(i->GetTransform().GetDepth(), &i->GetTransform());
+		ordered.insert(&i->GetTransform());
+	}
 	for (auto& i : gameObjects) {
-		i->GetTransform().UpdateMatrices();
+		for (Transform* p = i->GetTransform().GetParent(); p && ordered.insert(p).second; p = p->GetParent()) {
+			byDepth.emplace_back(p->GetDepth(), p);
+		}
+	}
+	std::stable_sort(byDepth.begin(), byDepth.end(),
+		[](const std::pair<int, Transform*>& a, const std::pair<int, Transform*>& b) {
+			return a.first < b.first;
+		});
+
+	transformOrder.clear();
+	transformLevels.clear();
+	transformOrder.reserve(byDepth.size());
+	for (auto& i : byDepth) {
+		while ((int)transformLevels.size() <= i.first) {
+			transformLevels.emplace_back(transformOrder.size());
+		}
+		transformOrder.emplace_back(i.second);
 	}
+	transformLevels.emplace_back(transformOrder.size());
+	transformOrderVersion	= Transform::GetHierarchyVersion();
+	transformOrderDirty		= false;
 }
 
 void GameWorld::UpdateQuadTree() {
@@ -5,6 +5,7 @@
 #include "QuadTree.h"
 namespace NCL {
 		class Camera;
+		class JobSystem;
 		using Maths::Ray;
 	namespace CSC8503 {
 		class GameObject;
@@ -36,6 +37,17 @@ namespace NCL {
 				shuffleObjects = state;
 			}
 
+			//Defaults to JobSystem::GetShared()
+			void SetJobSystem(JobSystem* jobs) {
+				jobSystem = jobs;
+			}
+
+			//Levels of the hierarchy with fewer transforms than this are updated
+			//on the calling thread - it's not worth waking the workers for
+			void SetParallelTransformThreshold(size_t count) {
+				parallelTransformThreshold = count;
+			}
+
 			bool Raycast(Ray& r, RayCollision& closestCollision, bool closestObject = false) const;
 
 			virtual void UpdateWorld(float dt);
@@ -50,10 +62,20 @@ namespace NCL {
 
 		protected:
 			void UpdateTransforms();
+			void SortTransforms();
 			void UpdateQuadTree();
 
 			std::vector<GameObject*> gameObjects;
 
+			//Every object's transform, parents before children
+			std::vector<Transform*> transformOrder;
+			std::vector<size_t>		transformLevels;	//where each depth starts in transformOrder, plus the end
+			unsigned int			transformOrderVersion;	//Transform::GetHierarchyVersion when last sorted
+			bool					transformOrderDirty;	//objects added or removed since
+
+			JobSystem*	jobSystem;
+			size_t		parallelTransformThreshold;
+
 			std::vector<Constraint*> constraints;
 
 			QuadTree<GameObject*>* quadTree;
@@ -0,0 +1,244 @@
+#include "LoopbackTransport.h"
+#include <algorithm>
+
+using namespace NCL;
+using namespace CSC8503;
+
+LoopbackNetwork::LoopbackNetwork(unsigned int seed) {
+	randomState			= seed ? seed : 1;
+	nextDelivery		= 0;
+	time				= 0.0;
+	packetsSent			= 0;
+	packetsLost			= 0;
+	packetsDuplicated	= 0;
+}
+
+LoopbackNetwork::~LoopbackNetwork() {
+}
+
+void LoopbackNetwork::SetConditions(const LoopbackConditions& c) {
+	std::lock_guard<std::mutex> lock(networkMutex);
+	conditions = c;
+}
+
+LoopbackConditions LoopbackNetwork::GetConditions() const {
+	std::lock_guard<std::mutex> lock(networkMutex);
+	return conditions;
+}
+
+void LoopbackNetwork::Update(float dtMS) {
+	std::lock_guard<std::mutex> lock(networkMutex);
+	time += dtMS;
+}
+
+double LoopbackNetwork::GetTime() const {
+	std::lock_guard<std::mutex> lock(networkMutex);
+	return time;
+}
+
+int LoopbackNetwork::GetPacketsSent() const {
+	std::lock_guard<std::mutex> lock(networkMutex);
+	return packetsSent;
+}
+
+int LoopbackNetwork::GetPacketsLost() const {
+	std::lock_guard<std::mutex> lock(networkMutex);
+	return packetsLost;
+}
+
+int LoopbackNetwork::GetPacketsDuplicated() const {
+	std::lock_guard<std::mutex> lock(networkMutex);
+	return packetsDuplicated;
+}
+
+//xorshift32 - the same sequence on every platform, unlike rand()
+float LoopbackNetwork::Random() {
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+	return (randomState >> 8) / (float)(1 << 24);
+}
+
+LoopbackTransport::LoopbackTransport(LoopbackNetwork& n, int maxPeers, int port) : network(n) {
+	listenPort = port;
+	peers.resize(std::max(maxPeers, 1));
+
+	if (listenPort >= 0) {
+		std::lock_guard<std::mutex> lock(network.networkMutex);
+		network.listeners[listenPort] = this;
+	}
+}
+
+/*
+Everyone still connected gets a DISCONNECT, timed to turn up after anything
+we've already sent them, however held back it was.
+*/
+LoopbackTransport::~LoopbackTransport() {
+	std::lock_guard<std::mutex> lock(network.networkMutex);
+
+	auto i = network.listeners.find(listenPort);
+	if (i != network.listeners.end() && i->second == this) {
+		network.listeners.erase(i);
+	}
+	const LoopbackConditions& c = network.conditions;
+	double disconnectTime = network.time + (2.0 * (c.latency + c.jitter));
+
+	for (LoopbackPeer& p : peers) {
+		if (!p.remote) {
+			continue;
+		}
+		LoopbackPeer& theirs = p.remote->peers[p.remotePeerID];
+		theirs.remote	= nullptr;
+		theirs.closing	= true;
+		p.remote->Deliver(std::max(disconnectTime, theirs.lastReliable), ENET_EVENT_TYPE_DISCONNECT, p.remotePeerID, nullptr);
+	}
+	for (auto& e : incoming) {
+		if (e.second.packet) {
+			enet_packet_destroy(e.second.packet);
+		}
+	}
+}
+
+int LoopbackTransport::FreePeer() const {
+	for (int i = 0; i < (int)peers.size(); ++i) {
+		if (!peers[i].remote && !peers[i].closing) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+/*
+Same as ENet, the client hears about the connection a round trip after
+asking for it, and the server halfway through that.
+*/
+int LoopbackTransport::Connect(const ENetAddress& address) {
+	std::lock_guard<std::mutex> lock(network.networkMutex);
+
+	auto i = network.listeners.find(address.port);
+	if (i == network.listeners.end() || i->second == this) {
+		return -1;
+	}
+	LoopbackTransport* server = i->second;
+
+	int localID		= FreePeer();
+	int remoteID	= server->FreePeer();
+	if (localID < 0 || remoteID < 0) {
+		return -1;
+	}
+	LoopbackPeer& local		= peers[localID];
+	LoopbackPeer& remote	= server->peers[remoteID];
+
+	local.remote		= server;
+	local.remotePeerID	= remoteID;
+	local.lastReliable	= network.time;
+	local.packetsSent	= 0;
+	local.packetsLost	= 0;
+
+	remote.remote		= this;
+	remote.remotePeerID = localID;
+	remote.lastReliable = network.time;
+	remote.packetsSent	= 0;
+	remote.packetsLost	= 0;
+
+	double latency = network.conditions.latency;
+	server->Deliver(network.time + latency, ENET_EVENT_TYPE_CONNECT, remoteID, nullptr);
+	Deliver(network.time + (latency * 2.0), ENET_EVENT_TYPE_CONNECT, localID, nullptr);
+	return localID;
+}
+
+bool LoopbackTransport::Service(NetworkEvent& e, int timeoutMS) {
+	std::lock_guard<std::mutex> lock(network.networkMutex);
+
+	if (incoming.empty() || incoming.begin()->first.first > network.time) {
+		return false;
+	}
+	e = incoming.begin()->second;
+	incoming.erase(incoming.begin());
+
+	if (e.type == ENET_EVENT_TYPE_DISCONNECT) {
+		peers[e.peerID].closing = false;
+	}
+	return true;
+}
+
+bool LoopbackTransport::GetPeerStats(int peerID, TransportPeerStats& stats) const {
+	std::lock_guard<std::mutex> lock(network.networkMutex);
+
+	if (peerID < 0 || peerID >= (int)peers.size() || !peers[peerID].remote) {
+		return false;
+	}
+	const LoopbackPeer&			peer	= peers[peerID];
+	const LoopbackConditions&	c		= network.conditions;
+
+	stats.roundTripTime		= (int)((c.latency * 2.0f) + c.jitter);
+	stats.roundTripJitter	= (int)c.jitter;
+	stats.packetLoss		= peer.packetsSent > 0 ? peer.packetsLost / (float)peer.packetsSent : 0.0f;
+	return true;
+}
+
+void LoopbackTransport::Send(int peerID, ENetPacket* packet) {
+	std::lock_guard<std::mutex> lock(network.networkMutex);
+	SendLocked(peerID, packet);
+}
+
+//Destroys the packet if nobody took it, same as enet_host_broadcast
+void LoopbackTransport::Broadcast(ENetPacket* packet) {
+	{
+		std::lock_guard<std::mutex> lock(network.networkMutex);
+		for (int i = 0; i < (int)peers.size(); ++i) {
+			SendLocked(i, packet);
+		}
+	}
+	if (packet->referenceCount == 0) {
+		enet_packet_destroy(packet);
+	}
+}
+
+/*
+Each receiver gets its own copy of the packet, so the sender's is never
+referenced by us, and can always be destroyed straight after sending.
+*/
+void LoopbackTransport::SendLocked(int peerID, ENetPacket* packet) {
+	if (peerID < 0 || peerID >= (int)peers.size() || !peers[peerID].remote) {
+		return;
+	}
+	LoopbackPeer&				peer	= peers[peerID];
+	const LoopbackConditions&	c		= network.conditions;
+
+	bool reliable = (packet->flags & ENET_PACKET_FLAG_RELIABLE) != 0;
+
+	network.packetsSent++;
+	peer.packetsSent++;
+	if (!reliable && network.Random() < c.lossChance) {
+		network.packetsLost++;
+		peer.packetsLost++;
+		return;
+	}
+	int copies = 1;
+	if (!reliable && network.Random() < c.duplicateChance) {
+		network.packetsDuplicated++;
+		copies = 2;
+	}
+	for (int i = 0; i < copies; ++i) {
+		double arrival = network.time + c.latency + (network.Random() * c.jitter);
+
+		if (reliable) {
+			arrival				= std::max(arrival, peer.lastReliable);
+			peer.lastReliable	= arrival;
+		}
+		else if (network.Random() < c.reorderChance) {
+			arrival += c.latency + c.jitter;
+		}
+		ENetPacket* copy = enet_packet_create(packet->data, packet->dataLength, packet->flags & ENET_PACKET_FLAG_RELIABLE);
+		peer.remote->Deliver(arrival, ENET_EVENT_TYPE_RECEIVE, peer.remotePeerID, copy);
+	}
+}
+
+void LoopbackTransport::Deliver(double time, ENetEventType type, int peerID, ENetPacket* packet) {
+	NetworkEvent e;
+	e.type		= type;
+	e.peerID	= peerID;
+	e.packet	= packet;
+	incoming.insert(std::make_pair(std::make_pair(time, network.nextDelivery++), e));
+}
\ No newline at end of file
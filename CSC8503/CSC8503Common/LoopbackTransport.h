@@ -0,0 +1,139 @@
+#pragma once
+#include "NetworkTransport.h"
+
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace NCL {
+	namespace CSC8503 {
+		class LoopbackTransport;
+
+		/*
+		How bad the pretend link between two LoopbackTransports is. Times are
+		in milliseconds, chances from 0 to 1. Like ENet, reliable packets are
+		never lost or duplicated, and arrive in the order they were sent - but
+		they're just as late as everything else.
+		*/
+		struct LoopbackConditions {
+			float latency;			//one way
+			float jitter;			//up to this much extra latency
+			float lossChance;
+			float duplicateChance;
+			float reorderChance;	//held back behind whatever's sent after it
+
+			LoopbackConditions() {
+				latency			= 0.0f;
+				jitter			= 0.0f;
+				lossChance		= 0.0f;
+				duplicateChance = 0.0f;
+				reorderChance	= 0.0f;
+			}
+		};
+
+		/*
+		The 'network' that LoopbackTransports in the same process talk over,
+		for testing servers and clients without any sockets. Nothing arrives
+		until Update has moved the network's clock on far enough, so tests
+		don't have to sleep, and every bit of loss, jitter etc. comes from one
+		seeded generator - the same test run with the same seed sends and
+		receives exactly the same packets, as long as it doesn't use network
+		threads. Must outlive every transport made on it.
+		*/
+		class LoopbackNetwork	{
+		public:
+			LoopbackNetwork(unsigned int seed = 1);
+			~LoopbackNetwork();
+
+			void SetConditions(const LoopbackConditions& c);
+			LoopbackConditions GetConditions() const;
+
+			//Moves the clock on - anything due by then can be received
+			void Update(float dtMS);
+
+			double GetTime() const;
+
+			int GetPacketsSent() const;
+			int GetPacketsLost() const;
+			int GetPacketsDuplicated() const;
+
+		protected:
+			friend class LoopbackTransport;
+
+			float Random(); //0 to 1, only while locked
+
+			mutable std::mutex	networkMutex;	//everything on this network shares it
+
+			LoopbackConditions	conditions;
+			std::map<int, LoopbackTransport*> listeners;	//by port
+
+			unsigned int	randomState;
+			unsigned int	nextDelivery;	//keeps packets due at the same time in order
+			double			time;
+
+			int packetsSent;
+			int packetsLost;
+			int packetsDuplicated;
+		};
+
+		class LoopbackTransport : public NetworkTransport	{
+		public:
+			//Servers pass the port clients will Connect to
+			LoopbackTransport(LoopbackNetwork& network, int maxPeers, int listenPort = -1);
+			~LoopbackTransport();
+
+			//Only the port matters. Fails straight away if nothing's listening there
+			int  Connect(const ENetAddress& address) override;
+			//Never waits, as time only moves in LoopbackNetwork::Update
+			bool Service(NetworkEvent& e, int timeoutMS) override;
+			void Send(int peerID, ENetPacket* packet) override;
+			void Broadcast(ENetPacket* packet) override;
+
+			void Flush() override {
+			}
+
+			//Packets are handed over whole, so there's nothing to compress
+			bool SetCompression(NetworkCompression mode) override {
+				return mode == NetworkCompression::None;
+			}
+
+			int GetPeerCount() const override {
+				return (int)peers.size();
+			}
+
+			//Round trip is worked out from the conditions, loss is what's really been lost
+			bool GetPeerStats(int peerID, TransportPeerStats& stats) const override;
+
+		protected:
+			struct LoopbackPeer {
+				LoopbackTransport*	remote;			//nullptr if this slot isn't connected
+				int					remotePeerID;	//our ID on the remote's end
+				double				lastReliable;	//arrival time of the latest reliable packet
+				bool				closing;		//DISCONNECT not received yet, so can't be reused
+				int					packetsSent;
+				int					packetsLost;
+
+				LoopbackPeer() {
+					remote			= nullptr;
+					remotePeerID	= -1;
+					lastReliable	= 0.0;
+					closing			= false;
+					packetsSent		= 0;
+					packetsLost		= 0;
+				}
+			};
+
+			//These all expect the network to be locked already
+			int		FreePeer() const;
+			void	SendLocked(int peerID, ENetPacket* packet);
+			void	Deliver(double time, ENetEventType type, int peerID, ENetPacket* packet);
+
+			LoopbackNetwork&	network;
+			int					listenPort;
+
+			std::vector<LoopbackPeer>	peers;
+			std::multimap<std::pair<double, unsigned int>, NetworkEvent> incoming;	//by arrival time, then send order
+		};
+	}
+}
\ No newline at end of file
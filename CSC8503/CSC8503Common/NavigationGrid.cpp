@@ -1,169 +1,367 @@
 #include "NavigationGrid.h"
 #include "../../Common/Assets.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <queue>
 
 using namespace NCL;
 using namespace CSC8503;
 
-const int LEFT_NODE		= 0;
-const int RIGHT_NODE	= 1;
-const int TOP_NODE		= 2;
-const int BOTTOM_NODE	= 3;
-
 const char WALL_NODE	= 'x';
 const char FLOOR_NODE	= '.';
 
+/*
+Binary grid layout. Everything is little endian, and each section starts on
+a 4 byte boundary so the region IDs can be used straight from the mapping.
+
+	NavGridFileHeader
+	char			cells[width * height]		at cellOffset
+	unsigned short	regions[width * height]		at regionOffset (if NAVGRID_HAS_REGIONS)
+
+Bump NAVGRID_FILE_VERSION whenever any of this changes!
+*/
+const char		NAVGRID_MAGIC[4]		= { 'N', 'G', 'R', 'D' };
+const uint32_t	NAVGRID_FILE_VERSION	= 1;
+const uint32_t	NAVGRID_HAS_REGIONS		= 1;
+
+const unsigned short NO_REGION			= 0xFFFF;
+
+struct NavGridFileHeader {
+	char		magic[4];
+	uint32_t	fileVersion;
+	int32_t		nodeSize;
+	int32_t		width;
+	int32_t		height;
+	uint32_t	flags;
+	uint32_t	cellOffset;
+	uint32_t	regionOffset;
+};
+
+static uint32_t AlignTo4(uint32_t value) {
+	return (value + 3) & ~3u;
+}
+
 NavigationGrid::NavigationGrid()	{
-	nodeSize	= 0;
-	gridWidth	= 0;
-	gridHeight	= 0;
-	allNodes	= nullptr;
+	nodeSize		= 0;
+	gridWidth		= 0;
+	gridHeight		= 0;
+	cells			= nullptr;
+	regions			= nullptr;
 }
 
 NavigationGrid::NavigationGrid(const std::string&filename) : NavigationGrid() {
-	std::ifstream infile(Assets::DATADIR + filename);
+	std::string filepath = Assets::DATADIR + filename;
+	std::ifstream infile(filepath, std::ios::binary);
+
+	char magic[4] = { 0 };
+	infile.read(magic, sizeof(magic));
+
+	if (infile && memcmp(magic, NAVGRID_MAGIC, sizeof(magic)) == 0) {
+		infile.close();
+		LoadBinary(filepath);
+	}
+	else {
+		infile.clear();
+		infile.seekg(0);
+		LoadText(infile);
+	}
+}
+
+NavigationGrid::~NavigationGrid()	{
+}
 
+void NavigationGrid::LoadText(std::istream& infile) {
 	infile >> nodeSize;
 	infile >> gridWidth;
 	infile >> gridHeight;
 
-	allNodes = new GridNode[gridWidth * gridHeight];
+	loadedCells.resize(gridWidth * gridHeight);
+	cells = loadedCells.data();
 
 	for (int y = 0; y < gridHeight; ++y) {
 		for (int x = 0; x < gridWidth; ++x) {
-			GridNode&n = allNodes[(gridWidth * y) + x];
 			char type = 0;
 			infile >> type;
-			n.type = type;
-			n.position = Vector3(x * nodeSize, 0, y * nodeSize);
+			cells[(gridWidth * y) + x] = type;
 		}
 	}
-	
-	//now to build the connectivity between the nodes
-	for (int y = 0; y < gridHeight; ++y) {
-		for (int x = 0; x < gridWidth; ++x) {
-			GridNode&n = allNodes[(gridWidth * y) + x];		
+}
 
-			if (y > 0) { //get the above node
-				n.connected[0] = &allNodes[(gridWidth * (y - 1)) + x];
-			}
-			if (y < gridHeight - 1) { //get the below node
-				n.connected[1] = &allNodes[(gridWidth * (y + 1)) + x];
-			}
-			if (x > 0) { //get left node
-				n.connected[2] = &allNodes[(gridWidth * (y)) + (x - 1)];
-			}
-			if (x < gridWidth - 1) { //get right node
-				n.connected[3] = &allNodes[(gridWidth * (y)) + (x + 1)];
-			}
-			for (int i = 0; i < 4; ++i) {
-				if (n.connected[i]) {
-					if (n.connected[i]->type == '.') {
-						n.costs[i]		= 1;
-					}
-					if (n.connected[i]->type == 'x') {
-						n.connected[i] = nullptr; //actually a wall, disconnect!
-					}
+bool NavigationGrid::LoadBinary(const std::string& filepath) {
+	if (!mappedFile.Open(filepath)) {
+		return false;
+	}
+	const char*	data	= mappedFile.Data();
+	size_t		size	= mappedFile.Size();
+
+	NavGridFileHeader header;
+	if (size < sizeof(header)) {
+		std::cout << __FUNCTION__ << " truncated grid file " << filepath << std::endl;
+		mappedFile.Close();
+		return false;
+	}
+	memcpy(&header, data, sizeof(header));
+
+	if (header.fileVersion != NAVGRID_FILE_VERSION) {
+		std::cout << __FUNCTION__ << " grid file " << filepath << " is version " << header.fileVersion
+			<< ", expected " << NAVGRID_FILE_VERSION << std::endl;
+		mappedFile.Close();
+		return false;
+	}
+	bool hasRegions = (header.flags & NAVGRID_HAS_REGIONS) != 0;
+
+	//Everything's checked against what's left of the file rather than by
+	//adding offsets together, so a huge offset or size can't wrap around
+	bool valid = header.width >= 0 && header.height >= 0 && header.nodeSize > 0;
+
+	uint64_t nodeCount	= valid ? (uint64_t)header.width * (uint64_t)header.height : 0;
+	uint64_t cellsEnd	= (uint64_t)header.cellOffset + nodeCount;
+
+	valid = valid && nodeCount <= INT32_MAX && header.cellOffset >= sizeof(header) && header.cellOffset % 4 == 0 &&
+		header.cellOffset <= size && nodeCount <= size - header.cellOffset;
+
+	if (valid && hasRegions) {
+		valid = header.regionOffset >= cellsEnd && header.regionOffset % 4 == 0 &&
+			header.regionOffset <= size && nodeCount <= (size - header.regionOffset) / sizeof(unsigned short);
+	}
+	if (!valid) {
+		std::cout << __FUNCTION__ << " corrupt grid file " << filepath << std::endl;
+		mappedFile.Close();
+		return false;
+	}
+	nodeSize	= header.nodeSize;
+	gridWidth	= header.width;
+	gridHeight	= header.height;
+
+	cells	= mappedFile.Data() + header.cellOffset;
+	regions = hasRegions ? (unsigned short*)(mappedFile.Data() + header.regionOffset) : nullptr;
+	return true;
+}
+
+bool NavigationGrid::SaveBinary(const std::string& filename, bool includeRegions) const {
+	std::string filepath = Assets::DATADIR + filename;
+	std::ofstream outfile(filepath, std::ios::binary);
+
+	if (!outfile) {
+		std::cout << __FUNCTION__ << " can't write file " << filepath << std::endl;
+		return false;
+	}
+	uint32_t nodeCount = (uint32_t)(gridWidth * gridHeight);
+
+	NavGridFileHeader header;
+	memcpy(header.magic, NAVGRID_MAGIC, sizeof(header.magic));
+	header.fileVersion	= NAVGRID_FILE_VERSION;
+	header.nodeSize		= nodeSize;
+	header.width		= gridWidth;
+	header.height		= gridHeight;
+	header.flags		= includeRegions ? NAVGRID_HAS_REGIONS : 0;
+	header.cellOffset	= AlignTo4(sizeof(header));
+	header.regionOffset = includeRegions ? AlignTo4(header.cellOffset + nodeCount) : 0;
+
+	std::vector<char> fileData(includeRegions ? header.regionOffset + (nodeCount * sizeof(unsigned short)) : header.cellOffset + nodeCount, 0);
+
+	memcpy(fileData.data(), &header, sizeof(header));
+	if (nodeCount > 0) {
+		memcpy(fileData.data() + header.cellOffset, cells, nodeCount);
+	}
+	if (includeRegions) {
+		std::vector<unsigned short> newRegions;
+		BuildRegions(newRegions);
+		memcpy(fileData.data() + header.regionOffset, newRegions.data(), nodeCount * sizeof(unsigned short));
+	}
+	outfile.write(fileData.data(), fileData.size());
+	return (bool)outfile;
+}
+
+bool NavigationGrid::ConvertTextToBinary(const std::string& textFile, const std::string& binaryFile) {
+	NavigationGrid grid(textFile);
+	if (!grid.cells) {
+		return false;
+	}
+	return grid.SaveBinary(binaryFile);
+}
+
+//Flood fills each connected patch of floor with its own ID
+void NavigationGrid::BuildRegions(std::vector<unsigned short>& outRegions) const {
+	int nodeCount = gridWidth * gridHeight;
+	outRegions.assign(nodeCount, NO_REGION);
+
+	unsigned short nextRegion = 0;
+	std::queue<int> toVisit;
+
+	for (int i = 0; i < nodeCount; ++i) {
+		if (cells[i] == WALL_NODE || outRegions[i] != NO_REGION) {
+			continue;
+		}
+		if (nextRegion == NO_REGION) { //run out of IDs, so leave the rest unknown
+			break;
+		}
+		outRegions[i] = nextRegion;
+		toVisit.push(i);
+
+		while (!toVisit.empty()) {
+			int current = toVisit.front();
+			toVisit.pop();
+
+			int x = current % gridWidth;
+			int y = current / gridWidth;
+
+			int neighbours[4] = { -1, -1, -1, -1 };
+			if (y > 0)				{ neighbours[0] = current - gridWidth; }
+			if (y < gridHeight - 1) { neighbours[1] = current + gridWidth; }
+			if (x > 0)				{ neighbours[2] = current - 1; }
+			if (x < gridWidth - 1)	{ neighbours[3] = current + 1; }
+
+			for (int n : neighbours) {
+				if (n >= 0 && cells[n] != WALL_NODE && outRegions[n] == NO_REGION) {
+					outRegions[n] = nextRegion;
+					toVisit.push(n);
 				}
 			}
-		}	
+		}
+		++nextRegion;
 	}
 }
 
-NavigationGrid::~NavigationGrid()	{
-	delete[] allNodes;
+Vector3 NavigationGrid::NodePosition(int index) const {
+	int x = index % gridWidth;
+	int y = index / gridWidth;
+	return Vector3((float)(x * nodeSize), 0, (float)(y * nodeSize));
 }
 
-bool NavigationGrid::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) {
-	//need to work out which node 'from' sits in, and 'to' sits in
-	int fromX = (from.x / nodeSize);
-	int fromZ = (from.z / nodeSize);
+char NavigationGrid::GetCellType(int x, int y) const {
+	if (!cells || x < 0 || x > gridWidth - 1 || y < 0 || y > gridHeight - 1) {
+		return WALL_NODE;
+	}
+	return cells[(gridWidth * y) + x];
+}
 
-	int toX = (to.x / nodeSize);
-	int toZ = (to.z / nodeSize);
+int NavigationGrid::GetCellID(const Vector3& pos) const {
+	if (nodeSize <= 0 || pos.x < 0 || pos.z < 0) {
+		return -1;
+	}
+	int x = (int)(pos.x / nodeSize);
+	int z = (int)(pos.z / nodeSize);
 
-	if (fromX<0 || fromX>gridWidth - 1 || fromZ<0 || toZ> gridHeight - 1) {
-		return false; // outside of map region!
+	if (x > gridWidth - 1 || z > gridHeight - 1) {
+		return -1;
 	}
+	return (z * gridWidth) + x;
+}
+
+void NavigationGrid::SetCellType(int x, int y, char type) {
+	if (!cells || x < 0 || x > gridWidth - 1 || y < 0 || y > gridHeight - 1) {
+		return;
+	}
+	std::unique_lock<std::shared_timed_mutex> lock(cellsMutex);
+
+	char& cell = cells[(gridWidth * y) + x];
+	if ((cell == WALL_NODE) != (type == WALL_NODE)) {
+		regions = nullptr; //connectivity might have changed
+	}
+	cell = type;
+	++version;
+}
 
-	GridNode* startNode = &allNodes[(fromZ* gridWidth) + fromX];
-	GridNode* endNode = &allNodes[(toZ* gridWidth) + toX];
+NavigationSearch* NavigationGrid::CreateSearch() const {
+	return new Search();
+}
+
+bool NavigationGrid::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath, NavigationSearch& baseSearch) const {
+	Search& search = (Search&)baseSearch;
+
+	//need to work out which node 'from' sits in, and 'to' sits in
+	int startIndex	= GetCellID(from);
+	int endIndex	= GetCellID(to);
+
+	if (startIndex < 0 || endIndex < 0) {
+		return false; // outside of map region!
+	}
+	std::shared_lock<std::shared_timed_mutex> lock(cellsMutex);
 
-	std::vector<GridNode*> openList;
-	std::vector<GridNode*> closedList;
+	if (regions && regions[startIndex] != NO_REGION && regions[endIndex] != NO_REGION &&
+		regions[startIndex] != regions[endIndex]) {
+		return false; //never going to get there from here
+	}
+	size_t nodeCount = (size_t)gridWidth * gridHeight;
+	if (search.g.size() != nodeCount) {
+		search.g.resize(nodeCount);
+		search.parent.resize(nodeCount);
+		search.opened.assign(nodeCount, -1);
+		search.closed.assign(nodeCount, -1);
+	}
+	int currentSearch = ++search.currentSearch; //invalidates everything left over from the last search
+	search.arena.Reset();
 
-	openList.emplace_back(startNode);
-	//
-	startNode->f = 0;
-	startNode->g = 0;
-	startNode->parent = nullptr;
+	//open list is a min-heap on f. Finding a better route to a node that's
+	//already open just pushes it again - the old entry is skipped when popped
+	typedef std::pair<float, int> OpenEntry;
+	FrameVector<OpenEntry> openList(&search.arena);
 
-	GridNode* currentBestNode = nullptr;
+	search.opened[startIndex]	= currentSearch;
+	search.g[startIndex]		= 0;
+	search.parent[startIndex]	= -1;
+	openList.emplace_back(Heuristic(startIndex, endIndex), startIndex);
 
 	while (!openList.empty()) {
-		currentBestNode = RemoveBestNode(openList);
+		std::pop_heap(openList.begin(), openList.end(), std::greater<OpenEntry>());
+		int current = openList.back().second;
+		openList.pop_back();
 
-		if (currentBestNode == endNode) {//we've found the path!
-			GridNode* node = endNode;
-			while (node != nullptr) {
-				outPath.PushWaypoint(node->position);
-				node = node->parent; // Build up the waypoints
+		if (search.closed[current] == currentSearch) {
+			continue; // already expanded via a better route
+		}
+		if (current == endIndex) {//we've found the path!
+			for (int node = endIndex; node != -1; node = search.parent[node]) {
+				outPath.PushWaypoint(NodePosition(node)); // Build up the waypoints
 			}
 			return true;
 		}
-		else {
-			for (int i = 0; i < 4; ++i) {
-				GridNode* neighbour = currentBestNode->connected[i];
-				if (!neighbour) { // might not be connected...
-					continue;
-				}
-				bool inClosed = NodeInList(neighbour, closedList);
-				if (inClosed) {
-					continue; // already discarded this neighbour...
-				}
+		search.closed[current] = currentSearch;
 
-				float h = Heuristic(neighbour, endNode);
-				float g = currentBestNode->g + currentBestNode->costs[i];
-				float f = h + g;
+		int x = current % gridWidth;
+		int y = current / gridWidth;
 
-				bool inOpen = NodeInList(neighbour, openList);
+		int neighbours[4] = { -1, -1, -1, -1 };
+		if (y > 0)				{ neighbours[0] = current - gridWidth; }	//above
+		if (y < gridHeight - 1) { neighbours[1] = current + gridWidth; }	//below
+		if (x > 0)				{ neighbours[2] = current - 1; }			//left
+		if (x < gridWidth - 1)	{ neighbours[3] = current + 1; }			//right
 
-				if (!inOpen) { // first time we've seen this neighbour
-					openList.emplace_back(neighbour);
-				}
-				//might be a better route to this node!
-				if (!inOpen || f < neighbour->f) {
-					neighbour->parent = currentBestNode;
-					neighbour->f = f;
-					neighbour->g = g;
-				}
+		for (int i = 0; i < 4; ++i) {
+			int neighbour = neighbours[i];
+			if (neighbour < 0 || cells[neighbour] == WALL_NODE) { // might not be connected...
+				continue;
 			}
-			closedList.emplace_back(currentBestNode);
-		} 
-	}
-	return false; //open list emptied out with no path!
-}
-
-bool NavigationGrid::NodeInList(GridNode* n, std::vector<GridNode*>& list) const {
-	std::vector<GridNode*>::iterator i = std::find(list.begin(), list.end(), n);
-	return i==list.end() ? false:true;
-}
+			if (search.closed[neighbour] == currentSearch) {
+				continue; // already discarded this neighbour...
+			}
+			float g = search.g[current] + 1.0f;
 
-GridNode*  NavigationGrid::RemoveBestNode(std::vector<GridNode*>& list) const {
-	std::vector<GridNode*>::iterator bestI = list.begin();
+			//might be a better route to this node!
+			if (search.opened[neighbour] != currentSearch || g < search.g[neighbour]) {
+				search.opened[neighbour]	= currentSearch;
+				search.g[neighbour]			= g;
+				search.parent[neighbour]	= current;
 
-	GridNode* bestNode = *list.begin();
-	for (auto i = list.begin(); i != list.end(); ++i) {
-		if ((*i)->f < bestNode->f) {
-			bestNode = (*i);
-			bestI = i;
+				openList.emplace_back(g + Heuristic(neighbour, endIndex), neighbour);
+				std::push_heap(openList.begin(), openList.end(), std::greater<OpenEntry>());
+			}
 		}
 	}
-	list.erase(bestI);
-	return bestNode;
+	return false; //open list emptied out with no path!
 }
 
-float NavigationGrid::Heuristic(GridNode* hNode, GridNode* endNode) const {
-	return (hNode->position-endNode->position).Length();
-}
\ No newline at end of file
+//Manhattan distance in nodes - each step costs 1, and there's no diagonals
+float NavigationGrid::Heuristic(int fromIndex, int toIndex) const {
+	int dx = abs((fromIndex % gridWidth) - (toIndex % gridWidth));
+	int dy = abs((fromIndex / gridWidth) - (toIndex / gridWidth));
+	return (float)(dx + dy);
+}
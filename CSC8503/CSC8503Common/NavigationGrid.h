@@ -1,51 +1,110 @@
 #pragma once
 #include "NavigationMap.h"
+#include "../../Common/MappedFile.h"
+#include "../../Common/FrameArena.h"
+#include <iosfwd>
+#include <shared_mutex>
 #include <string>
+#include <vector>
 namespace NCL {
 	namespace CSC8503 {
-		struct GridNode {
-			GridNode* parent;
+		/*
+		The grid is stored as one byte per node - just the character it was
+		loaded from. Neighbours are found from the node index, and positions
+		are worked out from the x/y coordinates when a path is built, so a
+		million node map's cells are a megabyte.
 
-			GridNode* connected[4];
-			int		  costs[4];
+		Everything A* needs to remember about a node lives in a Search's own
+		scratch arrays instead, so several threads can search the same grid
+		at once. That's another 16 bytes a node (g, parent, and the opened and
+		closed stamps) for every Search, allocated the first time it's used -
+		16MB more for each thread searching that million node map.
 
-			Vector3		position;
+		Grids can be loaded from the text format, or from the binary format
+		written by SaveBinary, which is mapped straight into memory and used
+		as-is. Binary grids can also carry a region ID for every node, so
+		searches between two places that can never reach each other fail
+		immediately instead of flooding the whole map.
+		*/
+		class NavigationGrid : public NavigationMap	{
+		public:
+			//Search scratch space, indexed the same as cells - 16 bytes a node
+			class Search : public NavigationSearch {
+			public:
+				Search() {
+					currentSearch = 0;
+				}
 
-			float f;
-			float g;
+				const FrameArena& GetArena() const {
+					return arena;
+				}
 
-			int type;
+			protected:
+				friend class NavigationGrid;
 
-			GridNode() {
-				for (int i = 0; i < 4; ++i) {
-					connected[i] = nullptr;
-					costs[i] = 0;
-				}
-				f = 0;
-				g = 0;
-				type = 0;
-				parent = nullptr;
-			}
-			~GridNode() {	}
-		};
+				std::vector<float>	g;
+				std::vector<int>	parent;
+				std::vector<int>	opened;	//== currentSearch if g / parent are valid
+				std::vector<int>	closed;	//== currentSearch once the node's been expanded
+				int					currentSearch;
+				FrameArena			arena;	//the open list, thrown away at the start of each search
+			};
 
-		class NavigationGrid : public NavigationMap	{
-		public:
 			NavigationGrid();
 			NavigationGrid(const std::string&filename);
 			~NavigationGrid();
 
-			bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) override;
-				
+			using NavigationMap::FindPath;
+			bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath, NavigationSearch& search) const override;
+			NavigationSearch* CreateSearch() const override;
+
+			int  GetCellID(const Vector3& pos) const override;
+
+			//Changes the type of a single node ('x' for wall, '.' for floor).
+			//Safe while other threads are searching - it waits for any search
+			//in progress to finish first, and bumps the version once it's done
+			void SetCellType(int x, int y, char type);
+
+			//From the thread that calls SetCellType. Anything off the grid (or
+			//on a grid that never loaded) is a wall
+			char GetCellType(int x, int y) const;
+
+			int GetWidth() const {
+				return gridWidth;
+			}
+
+			int GetHeight() const {
+				return gridHeight;
+			}
+
+			int GetNodeSize() const {
+				return nodeSize;
+			}
+
+			//Filenames are relative to the data directory, same as loading
+			bool SaveBinary(const std::string& filename, bool includeRegions = true) const;
+			static bool ConvertTextToBinary(const std::string& textFile, const std::string& binaryFile);
+
 		protected:
-			bool		NodeInList(GridNode* n, std::vector<GridNode*>& list) const;
-			GridNode*	RemoveBestNode(std::vector<GridNode*>& list) const;
-			float		Heuristic(GridNode* hNode, GridNode* endNode) const;
+			Vector3		NodePosition(int index) const;
+			float		Heuristic(int fromIndex, int toIndex) const;
+
+			void		LoadText(std::istream& infile);
+			bool		LoadBinary(const std::string& filepath);
+			void		BuildRegions(std::vector<unsigned short>& outRegions) const;
+
 			int nodeSize;
 			int gridWidth;
 			int gridHeight;
 
-			GridNode* allNodes;
+			char*				cells;		//points into either loadedCells or mappedFile
+			unsigned short*		regions;	//connected area for each node, null if unknown
+
+			std::vector<char>	loadedCells;
+			MappedFile			mappedFile;
+
+			//Searches hold this shared, and SetCellType exclusively
+			mutable std::shared_timed_mutex	cellsMutex;
 		};
 	}
 }
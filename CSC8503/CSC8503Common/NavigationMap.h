@@ -1,17 +1,64 @@
 #pragma once
 #include "../../Common/Vector3.h"
 #include "NavigationPath.h"
+#include <atomic>
 namespace NCL {
 	using namespace NCL::Maths;
 	namespace CSC8503 {
+		/*
+		Everything a single search has to keep track of as it goes - costs,
+		parents, the open list. Maps themselves aren't touched by searching,
+		so any number of threads can search the same map at once, as long
+		as each has a search of its own, made by that map's CreateSearch.
+		*/
+		class NavigationSearch {
+		public:
+			virtual ~NavigationSearch() {}
+		};
+
 		class NavigationMap
 		{
 		public:
-			NavigationMap() {}
-			~NavigationMap() {}
+			NavigationMap() {
+				version		= 0;
+				ownSearch	= nullptr;
+			}
+			virtual ~NavigationMap() {
+				delete ownSearch;
+			}
+
+			//Uses the map's own search, so only one thread at a time
+			bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) {
+				if (!ownSearch) {
+					ownSearch = CreateSearch();
+				}
+				return FindPath(from, to, outPath, *ownSearch);
+			}
+
+			virtual bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath, NavigationSearch& search) const = 0;
+
+			virtual NavigationSearch* CreateSearch() const = 0;
 
-			virtual bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) = 0;
+			//Which node / polygon a position falls in, so that requests starting and
+			//ending in the same places can share a search. -1 if it's off the map.
+			virtual int GetCellID(const Vector3& pos) const {
+				return -1;
+			}
+
+			//Bumped whenever the walkable layout changes, so anything holding
+			//on to old search results knows to throw them away. Safe to read
+			//from any thread
+			virtual unsigned int GetVersion() const {
+				return version;
+			}
+
+		protected:
+			NavigationMap(const NavigationMap&) = delete;
+			NavigationMap& operator=(const NavigationMap&) = delete;
+
+			std::atomic<unsigned int> version;
+
+			NavigationSearch* ownSearch;
 		};
 	}
-}
-
+}
\ No newline at end of file
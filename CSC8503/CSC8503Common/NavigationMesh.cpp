@@ -1,19 +1,440 @@
 #include "NavigationMesh.h"
+#include "../../Common/Vector2.h"
+#include "../../Common/Vector4.h"
+#include "../../Common/MeshGeometry.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <functional>
+#include <map>
+
 using namespace NCL;
 using namespace CSC8503;
 
+/*
+The navmesh is authored as an ordinary .msh file, so we reuse the MeshGeometry
+loader rather than writing another parser. MeshGeometry can't be created
+directly (it's waiting for an API to upload it to), so this just gives it an
+upload function that does nothing - we only want the CPU side data.
+*/
+class NavMeshGeometry : public MeshGeometry {
+public:
+	NavMeshGeometry(const std::string& filename) : MeshGeometry(filename) {
+	}
+	void UploadToGPU() override {
+	}
+};
+
+//Twice the signed area of the triangle abc, on the XZ plane. Everything about
+//which side of a portal a point is on comes from the sign of this.
+static float TriArea2(const Vector3& a, const Vector3& b, const Vector3& c) {
+	const float ax = b.x - a.x;
+	const float az = b.z - a.z;
+	const float bx = c.x - a.x;
+	const float bz = c.z - a.z;
+	return bx * az - ax * bz;
+}
+
+static bool SamePointXZ(const Vector3& a, const Vector3& b) {
+	const float epsilon = 0.001f;
+	return (fabs(a.x - b.x) < epsilon) && (fabs(a.z - b.z) < epsilon);
+}
+
 NavigationMesh::NavigationMesh()
 {
+	bucketSize		= 1.0f;
+	bucketsX		= 0;
+	bucketsZ		= 0;
 }
 
-NavigationMesh::NavigationMesh(const std::string&filename)
+NavigationMesh::NavigationMesh(const std::string&filename) : NavigationMesh()
 {
+	NavMeshGeometry mesh(filename);
+
+	BuildTriangles(mesh.GetPositionData(), mesh.GetIndexData());
+	BuildAdjacency();
+	BuildBuckets();
 }
 
 NavigationMesh::~NavigationMesh()
 {
 }
 
-bool NavigationMesh::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) {
-	return false;
+/*
+Exported meshes often duplicate vertices per face (Cube.msh has no index
+buffer at all!) so we weld identical positions together first - adjacency
+is worked out from shared vertex indices, so this has to happen before that.
+*/
+void NavigationMesh::BuildTriangles(const std::vector<Vector3>& positions, const std::vector<unsigned int>& inIndices) {
+	auto lessThan = [](const Vector3& a, const Vector3& b) {
+		if (a.x != b.x) { return a.x < b.x; }
+		if (a.y != b.y) { return a.y < b.y; }
+		return a.z < b.z;
+	};
+	std::map<Vector3, int, std::function<bool(const Vector3&, const Vector3&)>> welded(lessThan);
+
+	std::vector<int> remap(positions.size());
+	for (size_t i = 0; i < positions.size(); ++i) {
+		auto found = welded.find(positions[i]);
+		if (found == welded.end()) {
+			found = welded.insert(std::make_pair(positions[i], (int)vertices.size())).first;
+			vertices.emplace_back(positions[i]);
+		}
+		remap[i] = found->second;
+	}
+
+	int triCount = inIndices.empty() ? (int)positions.size() / 3 : (int)inIndices.size() / 3;
+	allTris.reserve(triCount);
+
+	for (int i = 0; i < triCount; ++i) {
+		NavTri t;
+		for (int j = 0; j < 3; ++j) {
+			int index = inIndices.empty() ? (i * 3) + j : (int)inIndices[(i * 3) + j];
+			t.indices[j] = remap[index];
+		}
+		if (t.indices[0] == t.indices[1] || t.indices[1] == t.indices[2] || t.indices[2] == t.indices[0]) {
+			continue; //degenerate, can't be walked across
+		}
+		t.centroid = (vertices[t.indices[0]] + vertices[t.indices[1]] + vertices[t.indices[2]]) / 3.0f;
+		allTris.emplace_back(t);
+	}
+}
+
+void NavigationMesh::BuildAdjacency() {
+	//edge (low index, high index) -> the first triangle / edge slot that used it
+	std::map<std::pair<int, int>, std::pair<int, int>> edges;
+
+	for (int i = 0; i < (int)allTris.size(); ++i) {
+		NavTri& t = allTris[i];
+		for (int j = 0; j < 3; ++j) {
+			int a = t.indices[j];
+			int b = t.indices[(j + 1) % 3];
+			std::pair<int, int> key(std::min(a, b), std::max(a, b));
+
+			auto found = edges.find(key);
+			if (found == edges.end()) {
+				edges.insert(std::make_pair(key, std::make_pair(i, j)));
+				continue;
+			}
+			NavTri& other = allTris[found->second.first];
+			if (other.neighbours[found->second.second] == nullptr) {
+				other.neighbours[found->second.second] = &t;
+				t.neighbours[j] = &other;
+			}
+		}
+	}
+}
+
+void NavigationMesh::BuildBuckets() {
+	buckets.clear();
+	if (vertices.empty()) {
+		return;
+	}
+	Vector3 boundsMax = vertices[0];
+	boundsMin = vertices[0];
+
+	for (const Vector3& v : vertices) {
+		boundsMin.x = std::min(boundsMin.x, v.x);
+		boundsMin.z = std::min(boundsMin.z, v.z);
+		boundsMax.x = std::max(boundsMax.x, v.x);
+		boundsMax.z = std::max(boundsMax.z, v.z);
+	}
+	//Aim for a couple of triangles per bucket along each axis
+	int perAxis = (int)sqrt((float)allTris.size()) + 1;
+	perAxis		= std::min(perAxis, 256);
+
+	float extent = std::max(boundsMax.x - boundsMin.x, boundsMax.z - boundsMin.z);
+	bucketSize	= std::max(extent / perAxis, 0.001f);
+	bucketsX	= (int)((boundsMax.x - boundsMin.x) / bucketSize) + 1;
+	bucketsZ	= (int)((boundsMax.z - boundsMin.z) / bucketSize) + 1;
+
+	buckets.resize(bucketsX * bucketsZ);
+
+	for (int i = 0; i < (int)allTris.size(); ++i) {
+		const NavTri& t = allTris[i];
+		Vector3 triMin = vertices[t.indices[0]];
+		Vector3 triMax = vertices[t.indices[0]];
+		for (int j = 1; j < 3; ++j) {
+			const Vector3& v = vertices[t.indices[j]];
+			triMin.x = std::min(triMin.x, v.x);
+			triMin.z = std::min(triMin.z, v.z);
+			triMax.x = std::max(triMax.x, v.x);
+			triMax.z = std::max(triMax.z, v.z);
+		}
+		int minX = (int)((triMin.x - boundsMin.x) / bucketSize);
+		int minZ = (int)((triMin.z - boundsMin.z) / bucketSize);
+		int maxX = std::min((int)((triMax.x - boundsMin.x) / bucketSize), bucketsX - 1);
+		int maxZ = std::min((int)((triMax.z - boundsMin.z) / bucketSize), bucketsZ - 1);
+
+		for (int z = minZ; z <= maxZ; ++z) {
+			for (int x = minX; x <= maxX; ++x) {
+				buckets[(z * bucketsX) + x].emplace_back(i);
+			}
+		}
+	}
+}
+
+bool NavigationMesh::PointInTri(const NavTri& t, const Vector3& pos, float& height) const {
+	const Vector3& a = vertices[t.indices[0]];
+	const Vector3& b = vertices[t.indices[1]];
+	const Vector3& c = vertices[t.indices[2]];
+
+	float area = TriArea2(a, b, c);
+	if (area == 0.0f) {
+		return false;
+	}
+	//barycentric weights, which also let us get the surface height
+	float u = TriArea2(b, c, pos) / area;
+	float v = TriArea2(c, a, pos) / area;
+	float w = 1.0f - u - v;
+
+	const float epsilon = -0.0001f;
+	if (u < epsilon || v < epsilon || w < epsilon) {
+		return false;
+	}
+	height = (a.y * u) + (b.y * v) + (c.y * w);
+	return true;
+}
+
+const NavTri* NavigationMesh::GetTriForPosition(const Vector3& pos) const {
+	if (buckets.empty()) {
+		return nullptr;
+	}
+	int x = (int)floor((pos.x - boundsMin.x) / bucketSize);
+	int z = (int)floor((pos.z - boundsMin.z) / bucketSize);
+
+	if (x < 0 || x >= bucketsX || z < 0 || z >= bucketsZ) {
+		return nullptr; // outside of mesh region!
+	}
+	//Meshes can overlap on XZ (bridges etc), so take the one nearest in height
+	const NavTri*	bestTri		= nullptr;
+	float			bestHeight	= FLT_MAX;
+
+	for (int i : buckets[(z * bucketsX) + x]) {
+		float height = 0.0f;
+		if (PointInTri(allTris[i], pos, height)) {
+			float heightDiff = fabs(height - pos.y);
+			if (heightDiff < bestHeight) {
+				bestHeight	= heightDiff;
+				bestTri		= &allTris[i];
+			}
+		}
+	}
+	return bestTri;
+}
+
+int NavigationMesh::GetCellID(const Vector3& pos) const {
+	const NavTri* t = GetTriForPosition(pos);
+	return t ? (int)(t - allTris.data()) : -1;
+}
+
+NavigationSearch* NavigationMesh::CreateSearch() const {
+	return new Search();
+}
+
+bool NavigationMesh::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath, NavigationSearch& baseSearch) const {
+	Search& search = (Search&)baseSearch;
+
+	int startTri	= GetCellID(from);
+	int endTri		= GetCellID(to);
+
+	if (startTri < 0 || endTri < 0) {
+		return false; // off the walkable surface!
+	}
+	search.arena.Reset();
+
+	if (!SearchTris(startTri, endTri, search)) {
+		return false;
+	}
+	StringPull(from, to, endTri, search, outPath);
+	return true;
+}
+
+/*
+A* across the triangle graph. Rather than clearing every triangle before a
+search, each one remembers which search last touched it - anything with an
+old searchID is treated as unvisited. The open list is a binary heap; when a
+better route to an open triangle is found it's just pushed again, and the
+stale copy is skipped when it eventually gets popped.
+*/
+bool NavigationMesh::SearchTris(int startTri, int endTri, Search& search) const {
+	if (search.tris.size() != allTris.size()) {
+		Search::TriState unvisited = { -1, 0.0f, 0.0f, -1, false };
+		search.tris.assign(allTris.size(), unvisited);
+	}
+	int currentSearch = ++search.currentSearch;
+	std::vector<Search::TriState>& states = search.tris;
+
+	auto worseThan = [&states](int a, int b) {
+		return states[a].f > states[b].f;
+	};
+	FrameVector<int> openList(&search.arena);
+
+	const Vector3& endCentroid = allTris[endTri].centroid;
+
+	states[startTri].searchID	= currentSearch;
+	states[startTri].closed		= false;
+	states[startTri].parent		= -1;
+	states[startTri].g			= 0.0f;
+	states[startTri].f			= (allTris[startTri].centroid - endCentroid).Length();
+
+	openList.emplace_back(startTri);
+
+	while (!openList.empty()) {
+		std::pop_heap(openList.begin(), openList.end(), worseThan);
+		int currentBestTri = openList.back();
+		openList.pop_back();
+
+		if (states[currentBestTri].closed) {
+			continue; //stale heap entry
+		}
+		if (currentBestTri == endTri) {
+			return true;
+		}
+		states[currentBestTri].closed = true;
+
+		const NavTri& current = allTris[currentBestTri];
+
+		for (int i = 0; i < 3; ++i) {
+			if (!current.neighbours[i]) {
+				continue;
+			}
+			int neighbour = (int)(current.neighbours[i] - allTris.data());
+			Search::TriState& state = states[neighbour];
+
+			bool seen = state.searchID == currentSearch;
+			if (seen && state.closed) {
+				continue;
+			}
+			float g = states[currentBestTri].g + (allTris[neighbour].centroid - current.centroid).Length();
+
+			if (!seen || g < state.g) {
+				state.searchID	= currentSearch;
+				state.closed	= false;
+				state.parent	= currentBestTri;
+				state.g			= g;
+				state.f			= g + (allTris[neighbour].centroid - endCentroid).Length();
+
+				openList.emplace_back(neighbour);
+				std::push_heap(openList.begin(), openList.end(), worseThan);
+			}
+		}
+	}
+	return false; //open list emptied out with no path!
+}
+
+int NavigationMesh::PortalEdge(const NavTri& from, const NavTri* to) const {
+	for (int i = 0; i < 3; ++i) {
+		if (from.neighbours[i] == to) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+/*
+The triangle corridor A* gives us is turned into a path using the 'simple
+stupid funnel algorithm' - we keep a funnel from the current apex through
+the left and right edges of each portal, narrowing it as we go, and whenever
+one side crosses over the other, that corner becomes a waypoint and the new
+apex. The result hugs corners instead of zig-zagging between centroids.
+*/
+void NavigationMesh::StringPull(const Vector3& from, const Vector3& to, int endTri, Search& search, NavigationPath& outPath) const {
+	FrameVector<const NavTri*> corridor(&search.arena);
+	for (int t = endTri; t != -1; t = search.tris[t].parent) {
+		corridor.emplace_back(&allTris[t]);
+	}
+	std::reverse(corridor.begin(), corridor.end());
+
+	FrameVector<Vector3> lefts(&search.arena);
+	FrameVector<Vector3> rights(&search.arena);
+
+	lefts.emplace_back(from);
+	rights.emplace_back(from);
+
+	for (size_t i = 0; i + 1 < corridor.size(); ++i) {
+		const NavTri& t = *corridor[i];
+		int edge = PortalEdge(t, corridor[i + 1]);
+
+		const Vector3& a = vertices[t.indices[edge]];
+		const Vector3& b = vertices[t.indices[(edge + 1) % 3]];
+
+		if (TriArea2(t.centroid, a, b) > 0.0f) {
+			lefts.emplace_back(a);
+			rights.emplace_back(b);
+		}
+		else {
+			lefts.emplace_back(b);
+			rights.emplace_back(a);
+		}
+	}
+	lefts.emplace_back(to);
+	rights.emplace_back(to);
+
+	FrameVector<Vector3> waypoints(&search.arena);
+
+	Vector3 portalApex	= lefts[0];
+	Vector3 portalLeft	= lefts[0];
+	Vector3 portalRight = rights[0];
+	int apexIndex	= 0;
+	int leftIndex	= 0;
+	int rightIndex	= 0;
+
+	waypoints.emplace_back(portalApex);
+
+	for (int i = 1; i < (int)lefts.size(); ++i) {
+		const Vector3& left		= lefts[i];
+		const Vector3& right	= rights[i];
+
+		//try to narrow the right side of the funnel
+		if (TriArea2(portalApex, portalRight, right) <= 0.0f) {
+			if (SamePointXZ(portalApex, portalRight) || TriArea2(portalApex, portalLeft, right) > 0.0f) {
+				portalRight = right;
+				rightIndex	= i;
+			}
+			else { //right crossed over left, so left becomes a corner
+				portalApex	= portalLeft;
+				apexIndex	= leftIndex;
+				if (!SamePointXZ(waypoints.back(), portalApex)) {
+					waypoints.emplace_back(portalApex);
+				}
+
+				portalLeft	= portalApex;
+				portalRight = portalApex;
+				leftIndex	= apexIndex;
+				rightIndex	= apexIndex;
+				i = apexIndex;
+				continue;
+			}
+		}
+		//and then the left side
+		if (TriArea2(portalApex, portalLeft, left) >= 0.0f) {
+			if (SamePointXZ(portalApex, portalLeft) || TriArea2(portalApex, portalRight, left) < 0.0f) {
+				portalLeft	= left;
+				leftIndex	= i;
+			}
+			else { //left crossed over right, so right becomes a corner
+				portalApex	= portalRight;
+				apexIndex	= rightIndex;
+				if (!SamePointXZ(waypoints.back(), portalApex)) {
+					waypoints.emplace_back(portalApex);
+				}
+
+				portalLeft	= portalApex;
+				portalRight = portalApex;
+				leftIndex	= apexIndex;
+				rightIndex	= apexIndex;
+				i = apexIndex;
+				continue;
+			}
+		}
+	}
+	if (!SamePointXZ(waypoints.back(), to)) {
+		waypoints.emplace_back(to);
+	}
+	//NavigationPath pops from the back, so push the end first
+	for (auto i = waypoints.rbegin(); i != waypoints.rend(); ++i) {
+		outPath.PushWaypoint(*i);
+	}
 }
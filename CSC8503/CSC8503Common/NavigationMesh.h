@@ -1,19 +1,87 @@
 #pragma once
 #include "NavigationMap.h"
+#include "../../Common/FrameArena.h"
 #include <string>
+#include <vector>
 
 namespace NCL {
 	namespace CSC8503 {
+		struct NavTri {
+			int		indices[3];		//into the welded vertex list
+			NavTri*	neighbours[3];	//neighbours[i] shares edge indices[i] -> indices[(i+1)%3]
+
+			Vector3	centroid;
+
+			NavTri() {
+				for (int i = 0; i < 3; ++i) {
+					indices[i]		= 0;
+					neighbours[i]	= nullptr;
+				}
+			}
+		};
+
 		class NavigationMesh : public NavigationMap	{
 		public:
+			//What A* knows about each triangle, indexed the same as allTris
+			class Search : public NavigationSearch {
+			public:
+				Search() {
+					currentSearch = 0;
+				}
+
+			protected:
+				friend class NavigationMesh;
+
+				struct TriState {
+					int		parent;
+					float	f;
+					float	g;
+					int		searchID;	//which search last touched f/g/parent
+					bool	closed;
+				};
+				std::vector<TriState>	tris;
+				int						currentSearch;
+
+				//the open list, corridor and funnel sides, thrown away at the start of each FindPath
+				FrameArena				arena;
+			};
+
 			NavigationMesh();
 			NavigationMesh(const std::string&filename);
 			~NavigationMesh();
 
-			bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) override;
-		
+			using NavigationMap::FindPath;
+			bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath, NavigationSearch& search) const override;
+			NavigationSearch* CreateSearch() const override;
+
+			int  GetCellID(const Vector3& pos) const override;
+
+			int GetTriangleCount() const {
+				return (int)allTris.size();
+			}
+
 		protected:
-	
+			void	BuildTriangles(const std::vector<Vector3>& positions, const std::vector<unsigned int>& inIndices);
+			void	BuildAdjacency();
+			void	BuildBuckets();
+
+			const NavTri*	GetTriForPosition(const Vector3& pos) const;
+			bool			PointInTri(const NavTri& t, const Vector3& pos, float& height) const;
+
+			bool	SearchTris(int startTri, int endTri, Search& search) const;
+			void	StringPull(const Vector3& from, const Vector3& to, int endTri, Search& search, NavigationPath& outPath) const;
+			int		PortalEdge(const NavTri& from, const NavTri* to) const;
+
+			std::vector<Vector3>	vertices;
+			std::vector<NavTri>		allTris;
+
+			//Uniform XZ grid of triangle lists, so point location only
+			//has to test the handful of triangles overlapping one cell
+			std::vector<std::vector<int>>	buckets;
+			Vector3	boundsMin;
+			float	bucketSize;
+			int		bucketsX;
+			int		bucketsZ;
 		};
 	}
-}
\ No newline at end of file
+}
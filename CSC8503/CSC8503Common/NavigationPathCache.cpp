@@ -0,0 +1,76 @@
+#include "NavigationPathCache.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+NavigationPathCache::NavigationPathCache(NavigationMap& m, int max) : map(m) {
+	maxEntries		= max;
+	cachedVersion	= map.GetVersion();
+	hits			= 0;
+	misses			= 0;
+}
+
+NavigationPathCache::~NavigationPathCache() {
+}
+
+void NavigationPathCache::Invalidate() {
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	InvalidateLocked();
+}
+
+void NavigationPathCache::InvalidateLocked() const {
+	entries.clear();
+	lookup.clear();
+	cachedVersion = map.GetVersion();
+}
+
+bool NavigationPathCache::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath, NavigationSearch& search) const {
+	unsigned int version	= map.GetVersion();
+	int startCell			= map.GetCellID(from);
+	int endCell				= map.GetCellID(to);
+
+	if (startCell < 0 || endCell < 0) { //can't key it, so don't cache it
+		++misses;
+		return map.FindPath(from, to, outPath, search);
+	}
+	PathKey key(startCell, endCell, version);
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		if (version != cachedVersion) {
+			InvalidateLocked(); //the map's been edited, none of the old paths can be trusted
+		}
+		auto found = lookup.find(key);
+		if (found != lookup.end()) {
+			++hits;
+			entries.splice(entries.begin(), entries, found->second); //now most recently used
+			const CacheEntry& entry = *found->second;
+			if (entry.found) {
+				outPath = entry.path;
+			}
+			return entry.found;
+		}
+	}
+	++misses;
+
+	CacheEntry entry;
+	entry.key	= key;
+	entry.found = map.FindPath(from, to, entry.path, search);
+
+	if (entry.found) {
+		outPath = entry.path;
+	}
+	bool result = entry.found;
+
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	if (version != cachedVersion || lookup.count(key)) {
+		return result; //stale already, or another thread got there first
+	}
+	entries.emplace_front(std::move(entry));
+	lookup.insert(std::make_pair(key, entries.begin()));
+
+	while ((int)entries.size() > maxEntries) {
+		lookup.erase(entries.back().key);
+		entries.pop_back();
+	}
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+#pragma once
+#include "NavigationMap.h"
+
+#include <atomic>
+#include <list>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		Sits in front of another NavigationMap, remembering the paths it has
+		found between pairs of cells. An agent asking for the same route
+		again (because neither end has moved into a different cell) gets a
+		copy of the old path instead of a new search. Whenever the wrapped
+		map's version changes, everything cached is thrown away.
+
+		Paths are shared by every position in the same pair of cells, which
+		is exact for grids, but on a navmesh the ends of a reused path are
+		wherever the original request started and finished.
+
+		Searches through the cache can happen on several threads at once, the
+		same as on the map it wraps. The cache itself is locked while it's
+		looked up or added to, but never for the search.
+		*/
+		class NavigationPathCache : public NavigationMap {
+		public:
+			NavigationPathCache(NavigationMap& map, int maxEntries = 64);
+			~NavigationPathCache();
+
+			using NavigationMap::FindPath;
+			bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath, NavigationSearch& search) const override;
+
+			NavigationSearch* CreateSearch() const override {
+				return map.CreateSearch();
+			}
+
+			int GetCellID(const Vector3& pos) const override {
+				return map.GetCellID(pos);
+			}
+
+			unsigned int GetVersion() const override {
+				return map.GetVersion();
+			}
+
+			void Invalidate();
+
+			int GetHitCount() const {
+				return hits;
+			}
+
+			int GetMissCount() const {
+				return misses;
+			}
+
+			void ResetCounters() {
+				hits	= 0;
+				misses	= 0;
+			}
+
+		protected:
+			typedef std::tuple<int, int, unsigned int> PathKey; //start cell, end cell, map version
+
+			struct CacheEntry {
+				PathKey			key;
+				bool			found;
+				NavigationPath	path;
+			};
+
+			void InvalidateLocked() const;
+
+			NavigationMap&	map;
+			int				maxEntries;
+
+			//Everything from here is guarded by cacheMutex - it's only a
+			//record of searches, so the cache still counts as const
+			mutable std::mutex	cacheMutex;
+			mutable unsigned int	cachedVersion;
+
+			//most recently used at the front
+			mutable std::list<CacheEntry>								entries;
+			mutable std::map<PathKey, std::list<CacheEntry>::iterator>	lookup;
+
+			mutable std::atomic<int> hits;
+			mutable std::atomic<int> misses;
+		};
+	}
+}
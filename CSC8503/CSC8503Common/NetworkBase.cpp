@@ -1,16 +1,18 @@
 #include "NetworkBase.h"
 #include <iostream>
 
-NetworkBase::NetworkBase()
+const int NETWORK_QUEUE_SIZE = 4096;
+
+NetworkBase::NetworkBase() : incomingEvents(NETWORK_QUEUE_SIZE), outgoingPackets(NETWORK_QUEUE_SIZE)
 {
-	netHandle = nullptr;
+	transport	= nullptr;
+	threadAlive = false;
 }
 
 NetworkBase::~NetworkBase()
 {
-	if (netHandle) {
-		enet_host_destroy(netHandle);
-	}
+	StopNetworkThread();
+	delete transport;
 }
 
 void NetworkBase::Initialise() {
@@ -21,17 +23,189 @@ void NetworkBase::Destroy() {
 	enet_deinitialize();
 }
 
-bool NetworkBase::ProcessPacket(GamePacket* packet, int peerID) {
-	PacketHandlerIterator firstHandler;
-	PacketHandlerIterator lastHandler;
+bool NetworkBase::ProcessPacket(const PacketView& view, int peerID) {
+	if (!view.IsValid()) {
+		std::cout << __FUNCTION__ << " packet is shorter than its header says!" << std::endl;
+		return false;
+	}
+	return ProcessPacket(view.packet, peerID);
+}
 
-	bool canHandle = GetPackethandlers(packet->type, firstHandler, lastHandler);
-	if (canHandle) {
-		for (auto i = firstHandler; i != lastHandler; ++i) {
-			i->second->ReceivePacket(packet->type, packet, peerID);
+//Only for packets whose size has already been checked against what arrived
+bool NetworkBase::ProcessPacket(GamePacket* packet, int peerID) {
+	if (packet->type == BasicNetworkMessages::Snapshot_State) {
+		return ProcessSnapshot((SnapshotPacket*)packet, peerID);
+	}
+	if (HasPacketHandlers(packet->type)) {
+		for (PacketReceiver* i : packetHandlers[packet->type]) {
+			i->ReceivePacket(packet->type, packet, peerID);
 		}
 		return true;
 	}
 	std::cout << __FUNCTION__ << "no handler for packet type" << packet->type << std::endl;
 	return false;
+}
+
+bool NetworkBase::ProcessSnapshot(SnapshotPacket* snapshot, int peerID) {
+	if (snapshot->GetTotalSize() < (int)sizeof(SnapshotPacket)) {
+		return false;
+	}
+	if (HasPacketHandlers(snapshot->type)) {
+		for (PacketReceiver* i : packetHandlers[snapshot->type]) {
+			i->ReceivePacket(snapshot->type, snapshot, peerID);
+		}
+	}
+	char*	data	= (char*)snapshot;
+	int		offset	= sizeof(SnapshotPacket);
+	int		end		= snapshot->GetTotalSize();
+
+	while (offset < end) {
+		PacketView view(data + offset, end - offset);
+		if (!view.IsValid()) {
+			std::cout << __FUNCTION__ << " malformed snapshot!" << std::endl;
+			return false;
+		}
+		if (view.packet->type != BasicNetworkMessages::Snapshot_State) { //no nesting!
+			ProcessPacket(view.packet, peerID);
+		}
+		offset += view.packet->GetTotalSize();
+	}
+	return true;
+}
+
+bool NetworkBase::SetCompression(NCL::CSC8503::NetworkCompression mode) {
+	if (!transport || threadAlive) {
+		return false;
+	}
+	return transport->SetCompression(mode);
+}
+
+bool NetworkBase::StartNetworkThread() {
+	if (!transport || threadAlive) {
+		return false;
+	}
+	threadAlive		= true;
+	updateThread	= std::thread(&NetworkBase::ThreadedUpdate, this);
+	return true;
+}
+
+void NetworkBase::StopNetworkThread() {
+	threadAlive = false;
+	if (updateThread.joinable()) {
+		updateThread.join();
+	}
+	NetworkEvent e;
+	while (incomingEvents.Pop(e)) { //nobody's going to read these now
+		if (e.packet) {
+			enet_packet_destroy(e.packet);
+		}
+	}
+}
+
+bool NetworkBase::GetNextEvent(NetworkEvent& e) {
+	if (threadAlive) {
+		return incomingEvents.Pop(e);
+	}
+	return transport && transport->Service(e, 0);
+}
+
+void NetworkBase::SendToPeer(ENetPacket* packet, int peerID) {
+	OutgoingPacket p;
+	p.packet = packet;
+	p.peerID = peerID;
+
+	if (!threadAlive) {
+		SendNow(p);
+		return;
+	}
+	while (!outgoingPackets.Push(p)) {
+		std::this_thread::yield(); //network thread will catch up
+	}
+}
+
+void NetworkBase::ReleasePacket(ENetPacket* packet) {
+	SendToPeer(packet, RELEASE_PACKET);
+}
+
+void NetworkBase::SendNow(const OutgoingPacket& p) {
+	if (p.peerID == ALL_PEERS) {
+		transport->Broadcast(p.packet);
+	}
+	else if (p.peerID == RELEASE_PACKET) {
+		if (p.packet->referenceCount == 0) { //never made it into a peer's queue
+			enet_packet_destroy(p.packet);
+		}
+	}
+	else {
+		transport->Send(p.peerID, p.packet); //if this fails, RELEASE_PACKET cleans up
+	}
+}
+
+/*
+The network thread never waits on the game thread - if incomingEvents is
+full, events wait in incomingBacklog until there's room, and outgoing
+packets are sent between every event received. The game thread can then
+spin on a full outgoingPackets in SendToPeer, knowing it'll be emptied.
+*/
+void NetworkBase::ThreadedUpdate() {
+	while (threadAlive) {
+		SendOutgoing();
+		QueueIncoming();
+		SampleLinkStats();
+
+		NetworkEvent e;
+		bool hasEvent = transport->Service(e, 1);
+		while (hasEvent) {
+			incomingBacklog.emplace_back(e);
+			QueueIncoming();
+			SendOutgoing();
+			hasEvent = transport->Service(e, 0);
+		}
+	}
+	for (NetworkEvent& e : incomingBacklog) { //nobody's going to read these now
+		if (e.packet) {
+			enet_packet_destroy(e.packet);
+		}
+	}
+	incomingBacklog.clear();
+
+	//Anything the game sent before stopping the thread should still go out
+	SendOutgoing();
+	transport->Flush();
+}
+
+void NetworkBase::SendOutgoing() {
+	OutgoingPacket out;
+	while (outgoingPackets.Pop(out)) {
+		SendNow(out);
+	}
+}
+
+void NetworkBase::QueueIncoming() {
+	while (!incomingBacklog.empty() && incomingEvents.Push(incomingBacklog.front())) {
+		incomingBacklog.pop_front();
+	}
+}
+
+void NetworkBase::SampleLinkStats() {
+	std::lock_guard<std::mutex> lock(linkStatsMutex);
+	linkStats.resize(transport->GetPeerCount());
+	for (int i = 0; i < (int)linkStats.size(); ++i) {
+		linkStats[i].first = transport->GetPeerStats(i, linkStats[i].second);
+	}
+}
+
+bool NetworkBase::GetLinkStats(int peerID, NCL::CSC8503::TransportPeerStats& stats) const {
+	if (!transport) {
+		return false;
+	}
+	if (!threadAlive) {
+		return transport->GetPeerStats(peerID, stats);
+	}
+	std::lock_guard<std::mutex> lock(linkStatsMutex);
+	if (peerID < 0 || peerID >= (int)linkStats.size() || !linkStats[peerID].first) {
+		return false;
+	}
+	stats = linkStats[peerID].second;
+	return true;
 }
\ No newline at end of file
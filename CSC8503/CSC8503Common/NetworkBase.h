@@ -1,7 +1,19 @@
 #pragma once
 #include <enet/enet.h>
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <deque>
 #include <map>
+#include <mutex>
+#include <new>
 #include <string>
+#include <thread>
+#include <vector>
+#include "NetworkTransport.h"
+#include "PacketPool.h"
+#include "SPSCQueue.h"
 
 enum BasicNetworkMessages {
 	None,
@@ -13,7 +25,8 @@ enum BasicNetworkMessages {
 	Received_State, //received from a client, informs that its received packet n
 	Player_Connected,
 	Player_Disconnected,
-	Shutdown
+	Shutdown,
+	Snapshot_State	//a SnapshotPacket header, followed by a batch of Full_State / Delta_State packets
 };
 
 struct GamePacket {
@@ -27,28 +40,46 @@ struct GamePacket {
 
 	GamePacket(short type) {
 		this->type	= type;
+		size		= 0;
 	}
 
-	int GetTotalSize() {
+	int GetTotalSize() const {
 		return sizeof(GamePacket) + size;
 	}
 };
 
+/*
+Only as many bytes of string as were sent follow the header - there's no
+terminator. Build one to send with a StringPacketBuffer.
+*/
 struct StringPacket : public GamePacket {
-	char	stringData[256];
-
-	StringPacket(const std::string& message) {
+	StringPacket() {
 		type = BasicNetworkMessages::String_Message;
-		size		= (short)message.length();
+		size = 0;
+	}
 
-		memcpy(stringData, message.data(), size);
-	};
+	std::string GetStringFromData() const {
+		return std::string((const char*)this + sizeof(StringPacket), size);
+	}
+};
 
-	std::string GetStringFromData() {
-		std::string realString(stringData);
-		realString.resize(size);
-		return realString;
+class StringPacketBuffer	{
+public:
+	StringPacketBuffer(const std::string& message) {
+		size_t length = std::min(message.length(), (size_t)SHRT_MAX);
+
+		buffer.resize(sizeof(StringPacket) + length);
+		StringPacket* packet = new (buffer.data()) StringPacket();
+		packet->size = (short)length;
+		memcpy(buffer.data() + sizeof(StringPacket), message.data(), length);
 	}
+
+	operator GamePacket&() {
+		return *(GamePacket*)buffer.data();
+	}
+
+protected:
+	std::vector<char> buffer;
 };
 
 struct NewPlayerPacket : public GamePacket {
@@ -69,6 +100,58 @@ struct PlayerDisconnectPacket : public GamePacket {
 	}
 };
 
+/*
+Lets the server send a whole tick's worth of object states in as few packets
+as possible. The header is followed by 'size - header' bytes of complete
+GamePackets, packed back to back, which are handed out to their own handlers
+after the header itself has been.
+
+A big snapshot is split over several of these, so each says which part it
+is and how many parts there are - a client mustn't acknowledge a full frame
+until every part has turned up, or the server would start sending deltas
+against states it never got.
+*/
+struct SnapshotPacket : public GamePacket {
+	int		snapshotID;
+	int		fullFrame;	//has full states later deltas will be against, so acknowledge it once every part's arrived
+	short	part;
+	short	partCount;
+
+	SnapshotPacket(int id = 0, bool full = false) {
+		type		= BasicNetworkMessages::Snapshot_State;
+		size		= sizeof(SnapshotPacket) - sizeof(GamePacket);
+		snapshotID	= id;
+		fullFrame	= full ? 1 : 0;
+		part		= 0;
+		partCount	= 1;
+	}
+};
+
+/*
+A packet straight out of an ENet receive buffer, along with how many bytes
+actually arrived, so that the header's size can be checked before anything
+trusts it. Nothing is copied.
+*/
+struct PacketView {
+	GamePacket*	packet;
+	int			length;
+
+	PacketView(void* data, int dataLength) {
+		packet	= (GamePacket*)data;
+		length	= dataLength;
+	}
+
+	bool IsValid() const {
+		return length >= (int)sizeof(GamePacket) && packet->size >= 0 &&
+			packet->GetTotalSize() <= length;
+	}
+
+	//nullptr if the packet's too small to be a T
+	template <class T> T* As() const {
+		return packet->GetTotalSize() >= (int)sizeof(T) ? (T*)packet : nullptr;
+	}
+};
+
 class PacketReceiver {
 public:
 	virtual void ReceivePacket(int type, GamePacket* payload, int source=-1) = 0;
@@ -84,29 +167,86 @@ public:
 	}
 
 	void RegisterPacketHandler(int msgID, PacketReceiver* receiver) {
-		packetHandlers.insert(std::make_pair(msgID, receiver));
+		if (msgID < 0) {
+			return;
+		}
+		if (msgID >= (int)packetHandlers.size()) {
+			packetHandlers.resize(msgID + 1);
+		}
+		packetHandlers[msgID].emplace_back(receiver);
 	}
 
+	/*
+	Optional - services the transport continuously on its own thread, so packets
+	keep flowing however long a frame takes. Anything received waits in a
+	queue until the next UpdateServer / UpdateClient, and sends are queued
+	up for the network thread to make. Clients should Connect first.
+	*/
+	bool StartNetworkThread();
+	void StopNetworkThread();
+
+	bool IsThreaded() const {
+		return threadAlive;
+	}
+
+	//Servers and their clients must all use the same mode. Set it before starting the network thread
+	bool SetCompression(NCL::CSC8503::NetworkCompression mode);
+
 protected:
 	NetworkBase();
 	~NetworkBase();
+
+	typedef NCL::CSC8503::NetworkEvent NetworkEvent;
+
+	struct OutgoingPacket {
+		ENetPacket*	packet;
+		int			peerID;	//or ALL_PEERS / RELEASE_PACKET
+	};
+
+	static const int ALL_PEERS		= -1;
+	static const int RELEASE_PACKET	= -2;
+
+	//Game thread side - these go straight to the transport, or via the network thread if it's running
+	bool GetNextEvent(NetworkEvent& e);
+	void SendToPeer(ENetPacket* packet, int peerID);
+	void ReleasePacket(ENetPacket* packet); //after the last SendToPeer, destroys it if nobody took it
+
+	//The transport's view of a peer's link - safe from the game thread, even while the network thread's running
+	bool GetLinkStats(int peerID, NCL::CSC8503::TransportPeerStats& stats) const;
+
+	void ThreadedUpdate();
+	void SendNow(const OutgoingPacket& p);
+	void SendOutgoing();
+	void QueueIncoming();
+	void SampleLinkStats();
 	
+	bool ProcessPacket(const PacketView& view, int peerID = -1);
 	bool ProcessPacket(GamePacket* p, int peerID = -1);
+	bool ProcessSnapshot(SnapshotPacket* p, int peerID);
 
-	typedef std::multimap<int, PacketReceiver*>::const_iterator PacketHandlerIterator;
-
-	bool GetPackethandlers(int msgID, PacketHandlerIterator& first, PacketHandlerIterator& last) const {
-		auto range = packetHandlers.equal_range(msgID);
+	bool HasPacketHandlers(int msgID) const {
+		return msgID >= 0 && msgID < (int)packetHandlers.size() && !packetHandlers[msgID].empty();
+	}
 
-		if (range.first == packetHandlers.end()) {
-			return false; //no handlers for this message type!
-		}
-		first	= range.first;
-		last	= range.second;
-		return true;
+	ENetPacket* CreatePacket(GamePacket& packet, enet_uint32 flags = 0) {
+		return packetPool.CreatePacket(&packet, packet.GetTotalSize(), flags);
 	}
 
-	ENetHost* netHandle;
+	NCL::CSC8503::NetworkTransport* transport;	//owned
+
+	std::vector<std::vector<PacketReceiver*>> packetHandlers;	//indexed by message type
+
+	NCL::CSC8503::PacketPool packetPool;
+
+	std::atomic<bool>	threadAlive;
+	std::thread			updateThread;
+
+	NCL::CSC8503::SPSCQueue<NetworkEvent>	incomingEvents;		//network thread -> game thread
+	NCL::CSC8503::SPSCQueue<OutgoingPacket>	outgoingPackets;	//game thread -> network thread
+
+	std::deque<NetworkEvent> incomingBacklog;	//network thread only, waiting for room in incomingEvents
 
-	std::multimap<int, PacketReceiver*> packetHandlers;
+	//Peer state belongs to the network thread while it's running, so it copies the stats out for everyone else
+	mutable std::mutex	linkStatsMutex;
+	std::vector<std::pair<bool, NCL::CSC8503::TransportPeerStats>>	linkStats;	//by peer ID - false if not connected
 };
\ No newline at end of file
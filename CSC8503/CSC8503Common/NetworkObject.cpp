@@ -1,49 +1,448 @@
 #include "NetworkObject.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 using namespace NCL;
 using namespace CSC8503;
 
+const int	STATE_HISTORY_SIZE		= 64;	//enough to cover a second of snapshots at 60hz
+
+const float POSITION_PRECISION		= 64.0f;	//steps per world unit
+const int	POSITION_WIDTH_BITS[4]	= { 0, 6, 11, 18 };	//picked by a 2 bit prefix per axis
+
+const int	ORIENTATION_BITS		= 10;	//per component, for the three smallest
+const float ORIENTATION_RANGE		= 0.707107f;	//smallest three can't be bigger than 1/sqrt(2)
+
+const int	INTERPOLATION_BUFFER_SIZE	= 32;
+
+/*
+Just enough of a bit stream to pack a DeltaPacket. Writing past the end
+of the buffer, or reading past the end of the data, fails rather than
+overrunning, so that the caller can fall back to a full packet / reject
+the packet instead.
+*/
+class DeltaBitWriter {
+public:
+	DeltaBitWriter(unsigned char* buffer, int bytes) {
+		data		= buffer;
+		maxBits		= bytes * 8;
+		bitCount	= 0;
+		memset(data, 0, bytes);
+	}
+
+	bool Write(unsigned int value, int bits) {
+		if (bitCount + bits > maxBits) {
+			return false;
+		}
+		for (int i = 0; i < bits; ++i, ++bitCount) {
+			if (value & (1u << i)) {
+				data[bitCount / 8] |= (unsigned char)(1 << (bitCount % 8));
+			}
+		}
+		return true;
+	}
+
+	int GetBytesUsed() const {
+		return (bitCount + 7) / 8;
+	}
+
+protected:
+	unsigned char*	data;
+	int				maxBits;
+	int				bitCount;
+};
+
+class DeltaBitReader {
+public:
+	DeltaBitReader(const unsigned char* buffer, int bytes) {
+		data		= buffer;
+		maxBits		= bytes * 8;
+		bitCount	= 0;
+	}
+
+	bool Read(unsigned int& value, int bits) {
+		if (bitCount + bits > maxBits) {
+			return false;
+		}
+		value = 0;
+		for (int i = 0; i < bits; ++i, ++bitCount) {
+			if (data[bitCount / 8] & (1 << (bitCount % 8))) {
+				value |= (1u << i);
+			}
+		}
+		return true;
+	}
+
+protected:
+	const unsigned char*	data;
+	int						maxBits;
+	int						bitCount;
+};
+
+//Maps signed values to unsigned so that small magnitudes need few bits
+static unsigned int ZigZag(int value) {
+	return ((unsigned int)value << 1) ^ (unsigned int)(value >> 31);
+}
+
+static int UnZigZag(unsigned int value) {
+	return (int)(value >> 1) ^ -(int)(value & 1);
+}
+
+/*
+Smallest three - the biggest component of a unit quaternion can be worked
+out from the other three, so only send which one it was, and the others
+at ORIENTATION_BITS each. q and -q are the same rotation, so flip it so
+that the missing component is always positive.
+*/
+static unsigned int PackOrientation(const Quaternion& q) {
+	float values[4] = { q.x, q.y, q.z, q.w };
+
+	int largest = 0;
+	for (int i = 1; i < 4; ++i) {
+		if (fabs(values[i]) > fabs(values[largest])) {
+			largest = i;
+		}
+	}
+	float sign		= values[largest] < 0.0f ? -1.0f : 1.0f;
+	int maxValue	= (1 << ORIENTATION_BITS) - 1;
+
+	unsigned int packed = (unsigned int)largest;
+	int shift = 2;
+	for (int i = 0; i < 4; ++i) {
+		if (i == largest) {
+			continue;
+		}
+		float normalised = ((values[i] * sign) + ORIENTATION_RANGE) / (2.0f * ORIENTATION_RANGE);
+		int quantised = (int)roundf(normalised * maxValue);
+		quantised = std::min(std::max(quantised, 0), maxValue);
+
+		packed |= (unsigned int)quantised << shift;
+		shift += ORIENTATION_BITS;
+	}
+	return packed;
+}
+
+static Quaternion UnpackOrientation(unsigned int packed) {
+	int largest		= packed & 3;
+	int maxValue	= (1 << ORIENTATION_BITS) - 1;
+
+	float values[4];
+	float sumSquares = 0.0f;
+	int shift = 2;
+	for (int i = 0; i < 4; ++i) {
+		if (i == largest) {
+			continue;
+		}
+		int quantised = (packed >> shift) & maxValue;
+		values[i] = ((quantised / (float)maxValue) * 2.0f * ORIENTATION_RANGE) - ORIENTATION_RANGE;
+		sumSquares += values[i] * values[i];
+		shift += ORIENTATION_BITS;
+	}
+	values[largest] = sqrt(std::max(0.0f, 1.0f - sumSquares));
+
+	Quaternion q(values[0], values[1], values[2], values[3]);
+	q.Normalise();
+	return q;
+}
+
 NetworkObject::NetworkObject(GameObject& o, int id) : object(o)	{
 	deltaErrors = 0;
 	fullErrors  = 0;
+	latestState = 0;
+	lastChangedState = 0;
 	networkID   = id;
+	isPredicted = false;
+
+	isInterpolated	= false;
+	packetTime		= 0.0f;
+
+	stateHistory.resize(STATE_HISTORY_SIZE);
+	for (auto& i : stateHistory) {
+		i.stateID = -1;
+	}
 }
 
 NetworkObject::~NetworkObject()	{
 }
 
 bool NetworkObject::ReadPacket(GamePacket& p) {
+	if (p.type == Delta_State && p.GetTotalSize() >= (int)(sizeof(DeltaPacket) - sizeof(DeltaPacket::data))) {
+		return ReadDeltaPacket((DeltaPacket&)p);
+	}
+	if (p.type == Full_State && p.GetTotalSize() >= (int)sizeof(FullPacket)) {
+		return ReadFullPacket((FullPacket&)p);
+	}
 	return false; //this isn't a packet we care about!
 }
 
-bool NetworkObject::WritePacket(GamePacket** p, bool deltaFrame) {
-	return false; //this isn't a packet we care about!
+bool NetworkObject::WritePacket(GamePacket** p, bool deltaFrame, int stateID) {
+	if (deltaFrame) {
+		if (!WriteDeltaPacket(p, stateID)) {
+			return WriteFullPacket(p);
+		}
+		return true;
+	}
+	return WriteFullPacket(p);
 }
 //Client objects recieve these packets
 bool NetworkObject::ReadDeltaPacket(DeltaPacket &p) {
+	NetworkState baseState;
+	if (!GetNetworkState(p.fullID, baseState)) {
+		deltaErrors++;
+		return false; //don't have the state this delta is from!
+	}
+	int dataSize = p.GetDataSize();
+	if (dataSize < 0 || dataSize > (int)sizeof(p.data)) {
+		deltaErrors++;
+		return false;
+	}
+	DeltaBitReader reader(p.data, dataSize);
+
+	Vector3		fullPos			= baseState.position;
+	Quaternion	fullOrientation	= baseState.orientation;
+
+	unsigned int hasChanged = 0;
+	if (!reader.Read(hasChanged, 1)) {
+		deltaErrors++;
+		return false;
+	}
+	if (hasChanged) {
+		for (int i = 0; i < 3; ++i) {
+			unsigned int widthIndex = 0;
+			unsigned int value		= 0;
+			if (!reader.Read(widthIndex, 2) || !reader.Read(value, POSITION_WIDTH_BITS[widthIndex])) {
+				deltaErrors++;
+				return false;
+			}
+			float offset = UnZigZag(value) / POSITION_PRECISION;
+			if (i == 0) { fullPos.x += offset; }
+			if (i == 1) { fullPos.y += offset; }
+			if (i == 2) { fullPos.z += offset; }
+		}
+	}
+	if (!reader.Read(hasChanged, 1)) {
+		deltaErrors++;
+		return false;
+	}
+	if (hasChanged) {
+		unsigned int packed = 0;
+		if (!reader.Read(packed, 2 + (ORIENTATION_BITS * 3))) {
+			deltaErrors++;
+			return false;
+		}
+		fullOrientation = UnpackOrientation(packed);
+	}
+	ApplyState(fullPos, fullOrientation);
 	return true;
 }
 
 bool NetworkObject::ReadFullPacket(FullPacket &p) {
+	if (p.fullState.stateID < lastFullState.stateID) {
+		fullErrors++;
+		return false; // received an 'old' packet, ignore!
+	}
+	lastFullState = p.fullState;
+
+	ApplyState(lastFullState.position, lastFullState.orientation);
+
+	stateHistory[lastFullState.stateID % STATE_HISTORY_SIZE] = lastFullState;
 	return true;
 }
 
-bool NetworkObject::WriteDeltaPacket(GamePacket**p) {
+/*
+Delta layout, least significant bit first:
+	1 bit	position changed
+		per axis:	2 bit width index, then a zigzagged offset of POSITION_WIDTH_BITS[index] bits,
+					in 1/POSITION_PRECISION units from the base position
+	1 bit	orientation changed
+		2 bit index of the dropped component, then 3 * ORIENTATION_BITS (see PackOrientation)
+
+Returns false if the object has moved too far from stateID to fit, so a
+full packet goes out instead.
+*/
+bool NetworkObject::WriteDeltaPacket(GamePacket**p, int stateID) {
+	NetworkState baseState;
+	if (stateID < 0 || !GetNetworkState(stateID, baseState)) {
+		return false; //can't delta this!
+	}
+	if (lastChangedState <= stateID) {
+		*p = nullptr;
+		return true; //client's had this exact state all along, nothing to send
+	}
+	Vector3 posDelta = lastFullState.position - baseState.position;
+
+	int quantisedPos[3] = {
+		(int)roundf(posDelta.x * POSITION_PRECISION),
+		(int)roundf(posDelta.y * POSITION_PRECISION),
+		(int)roundf(posDelta.z * POSITION_PRECISION)
+	};
+	int widthIndex[3] = { 0, 0, 0 };
+	for (int i = 0; i < 3; ++i) {
+		unsigned int value = ZigZag(quantisedPos[i]);
+		while (widthIndex[i] < 4 && (value >> POSITION_WIDTH_BITS[widthIndex[i]]) != 0) {
+			widthIndex[i]++;
+		}
+		if (widthIndex[i] == 4) {
+			return false; //moved too far to fit, send a full packet instead
+		}
+	}
+	bool posChanged = quantisedPos[0] != 0 || quantisedPos[1] != 0 || quantisedPos[2] != 0;
+
+	unsigned int packedOrientation	= PackOrientation(lastFullState.orientation);
+	bool orientationChanged			= packedOrientation != PackOrientation(baseState.orientation);
+
+	DeltaPacket* dp = new DeltaPacket();
+	dp->objectID	= networkID;
+	dp->fullID		= stateID;
+
+	DeltaBitWriter writer(dp->data, sizeof(dp->data));
+	bool fits = writer.Write(posChanged ? 1 : 0, 1);
+
+	if (posChanged) {
+		for (int i = 0; i < 3; ++i) {
+			fits = fits && writer.Write(widthIndex[i], 2);
+			fits = fits && writer.Write(ZigZag(quantisedPos[i]), POSITION_WIDTH_BITS[widthIndex[i]]);
+		}
+	}
+	fits = fits && writer.Write(orientationChanged ? 1 : 0, 1);
+	if (orientationChanged) {
+		fits = fits && writer.Write(packedOrientation, 2 + (ORIENTATION_BITS * 3));
+	}
+	if (!fits) {
+		delete dp;
+		return false;
+	}
+	dp->SetDataSize(writer.GetBytesUsed());
+	*p = dp;
 	return true;
 }
 
 bool NetworkObject::WriteFullPacket(GamePacket**p) {
+	FullPacket* fp = new FullPacket();
+
+	fp->objectID	= networkID;
+	fp->fullState	= lastFullState;
+
+	*p = fp;
 	return true;
 }
 
+void NetworkObject::ApplyState(const Vector3& position, const Quaternion& orientation) {
+	if (isPredicted) {
+		return;
+	}
+	if (!isInterpolated) {
+		object.GetTransform().SetWorldPosition(position);
+		object.GetTransform().SetLocalOrientation(orientation);
+		return;
+	}
+	TimedState state;
+	state.time			= packetTime;
+	state.position		= position;
+	state.orientation	= orientation;
+
+	//packets can turn up out of order, so keep the buffer sorted by time
+	auto i = interpolationBuffer.end();
+	while (i != interpolationBuffer.begin() && (i - 1)->time >= state.time) {
+		--i;
+	}
+	if (i != interpolationBuffer.end() && i->time == state.time) {
+		*i = state;
+	}
+	else {
+		interpolationBuffer.insert(i, state);
+	}
+	while ((int)interpolationBuffer.size() > INTERPOLATION_BUFFER_SIZE) {
+		interpolationBuffer.pop_front();
+	}
+}
+
+void NetworkObject::SetInterpolated(bool state) {
+	isInterpolated = state;
+	interpolationBuffer.clear();
+}
+
+void NetworkObject::UpdateInterpolation(float renderTime, float maxExtrapolation) {
+	if (!isInterpolated || interpolationBuffer.empty()) {
+		return;
+	}
+	//Only need one state from before renderTime - but hang on to two, to extrapolate from
+	while (interpolationBuffer.size() > 2 && interpolationBuffer[1].time <= renderTime) {
+		interpolationBuffer.pop_front();
+	}
+	Vector3		position;
+	Quaternion	orientation;
+
+	const TimedState& newest = interpolationBuffer.back();
+
+	if (interpolationBuffer.size() == 1 || renderTime <= interpolationBuffer.front().time) {
+		position	= interpolationBuffer.front().position;
+		orientation = interpolationBuffer.front().orientation;
+	}
+	else if (renderTime >= newest.time) {
+		const TimedState& previous = interpolationBuffer[interpolationBuffer.size() - 2];
+
+		float gap		= newest.time - previous.time;
+		float extra		= std::min(renderTime - newest.time, maxExtrapolation);
+		float by		= gap > 0.0f ? 1.0f + (extra / gap) : 1.0f;
+
+		position	= previous.position + ((newest.position - previous.position) * by);
+		orientation = Quaternion::Slerp(previous.orientation, newest.orientation, by);
+	}
+	else {
+		size_t next = 1;
+		while (interpolationBuffer[next].time < renderTime) {
+			++next;
+		}
+		const TimedState& from	= interpolationBuffer[next - 1];
+		const TimedState& to	= interpolationBuffer[next];
+
+		float by = (renderTime - from.time) / (to.time - from.time);
+
+		position	= from.position + ((to.position - from.position) * by);
+		orientation = Quaternion::Slerp(from.orientation, to.orientation, by);
+	}
+	object.GetTransform().SetWorldPosition(position);
+	object.GetTransform().SetLocalOrientation(orientation);
+}
+
 NetworkState& NetworkObject::GetLatestNetworkState() {
 	return lastFullState;
 }
 
 bool NetworkObject::GetNetworkState(int stateID, NetworkState& state) {
+	if (stateID < 0) {
+		return false;
+	}
+	NetworkState& s = stateHistory[stateID % STATE_HISTORY_SIZE];
+	if (s.stateID != stateID) {
+		return false; //been overwritten by a newer state
+	}
+	state = s;
+	return true;
+}
+
+void NetworkObject::RecordState(int stateID) {
+	Vector3		position	= object.GetTransform().GetWorldPosition();
+	Quaternion	orientation = object.GetTransform().GetWorldOrientation();
+
+	if (position != lastFullState.position || orientation != lastFullState.orientation) {
+		lastChangedState = stateID;
+	}
+	lastFullState.position		= position;
+	lastFullState.orientation	= orientation;
+	lastFullState.stateID		= stateID;
+	latestState					= stateID;
 
-	return false;
+	stateHistory[stateID % STATE_HISTORY_SIZE] = lastFullState;
 }
 
+//Forget any states that no client could still be using as a delta base
 void NetworkObject::UpdateStateHistory(int minID) {
+	for (auto& i : stateHistory) {
+		if (i.stateID < minID) {
+			i.stateID = -1;
+		}
+	}
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "GameObject.h"
 #include "NetworkBase.h"
 #include "NetworkState.h"
+#include <deque>
 namespace NCL {
 	namespace CSC8503 {
 		struct FullPacket : public GamePacket {
@@ -9,27 +10,55 @@ namespace NCL {
 			NetworkState fullState;
 
 			FullPacket() {
-				size = sizeof(FullPacket) + sizeof(int);
+				type = BasicNetworkMessages::Full_State;
+				size = sizeof(FullPacket) - sizeof(GamePacket);
 			}
 		};
 
+		/*
+		Bit packed changes since the state fullID - see NetworkObject::WriteDeltaPacket
+		for the layout. Only as many bytes of data as were written get sent.
+		*/
 		struct DeltaPacket : public GamePacket {
-			int		fullID;
-			int		objectID;
-			char	pos[3];
-			char	orientation[4];
+			int				fullID;
+			int				objectID;
+			unsigned char	data[12];
 
 			DeltaPacket() {
-				size = sizeof(DeltaPacket);
+				type = BasicNetworkMessages::Delta_State;
+				SetDataSize(sizeof(data));
+			}
+
+			void SetDataSize(int bytes) {
+				size = (short)(((char*)data - (char*)this) - sizeof(GamePacket) + bytes);
+			}
+
+			int GetDataSize() const {
+				return size - (int)(((char*)data - (char*)this) - sizeof(GamePacket));
 			}
 		};
 
+		/*
+		Sent by clients every tick. As well as acknowledging the newest full
+		snapshot, it carries the client's input for that tick. The newest shot
+		is repeated in every packet until the server has seen it, so losing a
+		packet never loses a shot - shotID says which input it was taken on.
+		*/
 		struct ClientPacket : public GamePacket {
 			int		lastID;
 			char	buttonstates[8];
+			int		inputID;	//goes up by one every client tick
+			int		shotID;		//inputID the newest shot was taken on, -1 if none yet
+			Vector3	shotForce;
+			Vector3	shotOffset;	//from the centre of the player's ball
 
 			ClientPacket() {
-				size = sizeof(ClientPacket);
+				type = BasicNetworkMessages::Received_State;
+				size = sizeof(ClientPacket) - sizeof(GamePacket);
+				lastID	= -1;
+				inputID = -1;
+				shotID	= -1;
+				memset(buttonstates, 0, sizeof(buttonstates));
 			}
 		};
 
@@ -40,36 +69,90 @@ namespace NCL {
 
 			//Called by clients
 			virtual bool ReadPacket(GamePacket& p);
-			//Called by servers
-			virtual bool WritePacket(GamePacket** p, bool deltaFrame);
+			//Called by servers - deltas are against the client's acknowledged stateID,
+			//falling back to a full packet if that state has already been forgotten.
+			//Leaves *p null if the object hasn't changed at all since stateID
+			virtual bool WritePacket(GamePacket** p, bool deltaFrame, int stateID);
+
+			//Called by servers once per snapshot, before any packets are written
+			void RecordState(int stateID);
 
 			void UpdateStateHistory(int minID);
 
-		protected:
+			int GetNetworkID() const {
+				return networkID;
+			}
 
 			NetworkState& GetLatestNetworkState();
 
+			//Predicted objects are moved by the client itself, so packets
+			//only keep their states up to date as a base for deltas
+			void SetPredicted(bool state) {
+				isPredicted = state;
+			}
+
+			bool IsPredicted() const {
+				return isPredicted;
+			}
+
+			/*
+			Interpolated objects don't jump to each state as it's read. Instead,
+			states are kept along with the server time they were sent at, and
+			UpdateInterpolation puts the object where it was at renderTime, which
+			should trail the newest state by enough that there's usually one on
+			either side of it. Past the newest state, the object carries on the
+			way it was going for at most maxExtrapolation seconds, then stops.
+			*/
+			void SetInterpolated(bool state);
+
+			bool IsInterpolated() const {
+				return isInterpolated;
+			}
+
+			//Server time of the states in the packets read after this
+			void SetPacketTime(float serverTime) {
+				packetTime = serverTime;
+			}
+
+			void UpdateInterpolation(float renderTime, float maxExtrapolation);
+
+		protected:
+
 			bool GetNetworkState(int frameID, NetworkState& state);
 
 
 			virtual bool ReadDeltaPacket(DeltaPacket &p);
 			virtual bool ReadFullPacket(FullPacket &p);
 
-			virtual bool WriteDeltaPacket(GamePacket**p);
+			virtual bool WriteDeltaPacket(GamePacket**p, int stateID);
 			virtual bool WriteFullPacket(GamePacket**p);
 
+			void ApplyState(const Vector3& position, const Quaternion& orientation);
+
+			struct TimedState {
+				float		time;
+				Vector3		position;
+				Quaternion	orientation;
+			};
+
 			GameObject& object;
 
 			NetworkState lastFullState;
 
-			std::vector<NetworkState> stateHistory;
+			std::vector<NetworkState> stateHistory;	//ring buffer, indexed by stateID % size
 
 			int latestState;
+			int lastChangedState;	//newest state that differed from the one before it
 
 			int deltaErrors;
 			int fullErrors;
 
 			int networkID;
+			bool isPredicted;
+
+			bool					isInterpolated;
+			float					packetTime;
+			std::deque<TimedState>	interpolationBuffer;	//oldest first
 		};
 	}
 }
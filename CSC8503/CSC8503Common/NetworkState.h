@@ -5,13 +5,19 @@
 namespace NCL {
 	using namespace Maths;
 	namespace CSC8503 {
+		//Packets are copied in and out of snapshot buffers at any offset, and
+		//read back by casting, so what's in them has to be plain floats - and
+		//the same size - whether NCL_MATHS_SIMD is on or not
+		static_assert(alignof(Vector3) == alignof(float) && sizeof(Vector3) == sizeof(float) * 3, "Vector3 isn't safe to send");
+		static_assert(alignof(Quaternion) == alignof(float) && sizeof(Quaternion) == sizeof(float) * 4, "Quaternion isn't safe to send");
+
 		class GameObject;
 		class NetworkState	{
 		public:
 			NetworkState() {
 				stateID = 0;
 			}
-			virtual ~NetworkState();
+			virtual ~NetworkState() {}
 
 			Vector3		position;
 			Quaternion	orientation;
@@ -0,0 +1,62 @@
+#pragma once
+#include <enet/enet.h>
+
+namespace NCL {
+	namespace CSC8503 {
+		struct NetworkEvent {
+			ENetEventType	type;
+			int				peerID;
+			ENetPacket*		packet;	//owned by whoever takes the event
+		};
+
+		//Both ends of a connection have to use the same one
+		enum class NetworkCompression {
+			None,
+			RangeCoder,	//ENet's own adaptive range coder
+			Snapshot	//see SnapshotCompressor
+		};
+
+		//What a transport knows about its link to one peer. Times are in milliseconds
+		struct TransportPeerStats {
+			int		roundTripTime;
+			int		roundTripJitter;
+			float	packetLoss;	//0 to 1
+
+			TransportPeerStats() {
+				roundTripTime	= 0;
+				roundTripJitter = 0;
+				packetLoss		= 0.0f;
+			}
+		};
+
+		/*
+		Whatever actually gets packets between a NetworkBase and its peers.
+		Packets are ENetPackets whichever transport is in use, and are sent
+		the way enet_peer_send sends them - a transport that holds on to a
+		packet bumps its referenceCount, and destroys it once it's done with
+		it, so a packet nothing took can be destroyed as soon as it's sent.
+		*/
+		class NetworkTransport	{
+		public:
+			virtual ~NetworkTransport() {}
+
+			//Returns the new peer's ID, or -1. A CONNECT event turns up once it's connected
+			virtual int  Connect(const ENetAddress& address) = 0;
+
+			//Gets the next event, waiting up to timeoutMS for one to arrive
+			virtual bool Service(NetworkEvent& e, int timeoutMS) = 0;
+
+			virtual void Send(int peerID, ENetPacket* packet) = 0;
+			virtual void Broadcast(ENetPacket* packet) = 0;
+			virtual void Flush() = 0;
+
+			virtual int  GetPeerCount() const = 0;
+
+			//False if the transport can't do that mode
+			virtual bool SetCompression(NetworkCompression mode) = 0;
+
+			//False if the peer isn't connected
+			virtual bool GetPeerStats(int peerID, TransportPeerStats& stats) const = 0;
+		};
+	}
+}
\ No newline at end of file
@@ -11,6 +11,9 @@ namespace NCL {
 		}
 		~OBBVolume() {}
 
+		using CollisionVolume::operator new;
+		using CollisionVolume::operator delete;
+
 		Maths::Vector3 GetHalfDimensions() const {
 			return halfSizes;
 		}
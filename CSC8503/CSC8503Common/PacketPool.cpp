@@ -0,0 +1,52 @@
+#include "PacketPool.h"
+#include <cstring>
+
+using namespace NCL;
+using namespace CSC8503;
+
+PacketPool::PacketPool(int size)	{
+	bufferSize	= size;
+	bufferCount = 0;
+}
+
+PacketPool::~PacketPool()	{
+	for (char* i : freeBuffers) {
+		delete[] i;
+	}
+}
+
+ENetPacket* PacketPool::CreatePacket(const void* data, size_t length, enet_uint32 flags) {
+	if (length > (size_t)bufferSize) {
+		return enet_packet_create(data, length, flags);
+	}
+	char* buffer = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(poolMutex);
+		if (freeBuffers.empty()) {
+			buffer = new char[bufferSize];
+			bufferCount++;
+		}
+		else {
+			buffer = freeBuffers.back();
+			freeBuffers.pop_back();
+		}
+	}
+	memcpy(buffer, data, length);
+
+	ENetPacket* packet = enet_packet_create(buffer, length, flags | ENET_PACKET_FLAG_NO_ALLOCATE);
+	if (!packet) {
+		std::lock_guard<std::mutex> lock(poolMutex);
+		freeBuffers.emplace_back(buffer);
+		return nullptr;
+	}
+	packet->userData		= this;
+	packet->freeCallback	= &PacketPool::ReturnBuffer;
+	return packet;
+}
+
+void ENET_CALLBACK PacketPool::ReturnBuffer(ENetPacket* packet) {
+	PacketPool* pool = (PacketPool*)packet->userData;
+
+	std::lock_guard<std::mutex> lock(pool->poolMutex);
+	pool->freeBuffers.emplace_back((char*)packet->data);
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+#include <enet/enet.h>
+#include <mutex>
+#include <vector>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		Hands out ENet packets whose data lives in recycled buffers, rather
+		than ENet allocating (and freeing) a fresh copy for every packet sent.
+		Buffers come back when ENet is done with the packet, which might be
+		on whichever thread is servicing the host, so the free list is locked.
+
+		Anything bigger than a buffer just goes through enet_packet_create.
+		The pool must outlive any host its packets have been sent through.
+		*/
+		class PacketPool	{
+		public:
+			PacketPool(int bufferSize = ENET_HOST_DEFAULT_MTU);
+			~PacketPool();
+
+			ENetPacket* CreatePacket(const void* data, size_t length, enet_uint32 flags = 0);
+
+			int GetBufferCount() const {
+				return bufferCount;
+			}
+
+		protected:
+			static void ENET_CALLBACK ReturnBuffer(ENetPacket* packet);
+
+			std::mutex			poolMutex;
+			std::vector<char*>	freeBuffers;
+			int					bufferSize;
+			int					bufferCount;	//free and in flight
+		};
+	}
+}
@@ -0,0 +1,170 @@
+#include "PathRequestQueue.h"
+
+#include <chrono>
+
+using namespace NCL;
+using namespace CSC8503;
+
+PathRequestQueue::PathRequestQueue(NavigationMap& m, int workerCount, float budget) : map(m) {
+	nextTicket		= 0;
+	frameBudgetMS	= budget;
+	budgetLeftMS	= budget;
+	threadAlive		= true;
+	updateSearch	= nullptr;
+
+	for (int i = 0; i < workerCount; ++i) {
+		workers.emplace_back(&PathRequestQueue::WorkerThread, this);
+	}
+}
+
+PathRequestQueue::~PathRequestQueue() {
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		threadAlive = false;
+	}
+	queueReady.notify_all();
+
+	for (auto& i : workers) {
+		i.join();
+	}
+	for (auto& i : pendingJobs) {
+		delete i;
+	}
+	for (auto& i : finishedJobs) {
+		delete i;
+	}
+	delete updateSearch;
+}
+
+PathTicket PathRequestQueue::RequestPath(const Vector3& from, const Vector3& to) {
+	int startCell	= map.GetCellID(from);
+	int endCell		= map.GetCellID(to);
+	bool canShare	= startCell >= 0 && endCell >= 0;
+
+	PathTicket ticket = nextTicket++;
+	outstandingTickets.insert(ticket);
+
+	std::lock_guard<std::mutex> lock(queueMutex);
+
+	if (canShare) {
+		auto existing = jobsByCell.find(std::make_pair(startCell, endCell));
+		if (existing != jobsByCell.end()) {
+			existing->second->tickets.emplace_back(ticket);
+			return ticket; //someone's already asking for this route
+		}
+	}
+	PathJob* job	= new PathJob();
+	job->from		= from;
+	job->to			= to;
+	job->startCell	= startCell;
+	job->endCell	= endCell;
+	job->found		= false;
+	job->tickets.emplace_back(ticket);
+
+	pendingJobs.emplace_back(job);
+	if (canShare) {
+		jobsByCell.insert(std::make_pair(std::make_pair(startCell, endCell), job));
+	}
+	queueReady.notify_one();
+	return ticket;
+}
+
+PathRequestStatus PathRequestQueue::CollectPath(PathTicket ticket, NavigationPath& outPath) {
+	auto result = deliveredResults.find(ticket);
+
+	if (result != deliveredResults.end()) {
+		bool found = result->second.found;
+		if (found) {
+			outPath = result->second.path;
+		}
+		deliveredResults.erase(result);
+		return found ? PathRequestStatus::Found : PathRequestStatus::NoPath;
+	}
+	if (outstandingTickets.count(ticket)) {
+		return PathRequestStatus::Pending;
+	}
+	return PathRequestStatus::Invalid;
+}
+
+void PathRequestQueue::Update() {
+	std::vector<PathJob*> justFinished;
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		budgetLeftMS = frameBudgetMS;
+	}
+	queueReady.notify_all();
+
+	if (workers.empty()) { //no threads, so spend the budget here instead
+		if (!updateSearch) {
+			updateSearch = map.CreateSearch();
+		}
+		while (true) {
+			PathJob* job = nullptr;
+			{
+				std::lock_guard<std::mutex> lock(queueMutex);
+				if (pendingJobs.empty() || budgetLeftMS <= 0.0f) {
+					break;
+				}
+				job = pendingJobs.front();
+				pendingJobs.pop_front();
+			}
+			RunJob(job, *updateSearch);
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		justFinished.swap(finishedJobs);
+	}
+	for (PathJob* job : justFinished) {
+		for (PathTicket t : job->tickets) {
+			PathResult& result = deliveredResults[t];
+			result.found	= job->found;
+			result.path		= job->path;
+			outstandingTickets.erase(t);
+		}
+		delete job;
+	}
+}
+
+void PathRequestQueue::WorkerThread() {
+	NavigationSearch* search = map.CreateSearch();
+
+	while (true) {
+		PathJob* job = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			queueReady.wait(lock, [&] {
+				return !threadAlive || (!pendingJobs.empty() && budgetLeftMS > 0.0f);
+			});
+			if (!threadAlive) {
+				break;
+			}
+			job = pendingJobs.front();
+			pendingJobs.pop_front();
+		}
+		RunJob(job, *search);
+	}
+	delete search;
+}
+
+void PathRequestQueue::RunJob(PathJob* job, NavigationSearch& search) {
+	auto start = std::chrono::high_resolution_clock::now();
+	job->found = map.FindPath(job->from, job->to, job->path, search);
+	auto end = std::chrono::high_resolution_clock::now();
+	float ms = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0f;
+
+	std::lock_guard<std::mutex> lock(queueMutex);
+	budgetLeftMS -= ms;
+	FinishJob(job);
+}
+
+//Must be called with queueMutex held
+void PathRequestQueue::FinishJob(PathJob* job) {
+	if (job->startCell >= 0 && job->endCell >= 0) {
+		auto i = jobsByCell.find(std::make_pair(job->startCell, job->endCell));
+		if (i != jobsByCell.end() && i->second == job) {
+			jobsByCell.erase(i);
+		}
+	}
+	finishedJobs.emplace_back(job);
+}
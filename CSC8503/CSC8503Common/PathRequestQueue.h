@@ -0,0 +1,99 @@
+#pragma once
+#include "NavigationMap.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace NCL {
+	namespace CSC8503 {
+		typedef int PathTicket;
+
+		enum class PathRequestStatus {
+			Pending,	//still queued or being searched
+			Found,		//outPath has been filled in
+			NoPath,		//search finished, but there's no route
+			Invalid		//unknown ticket, or already collected
+		};
+
+		/*
+		Moves pathfinding off the game thread. Agents hand in a start and end
+		position and get a ticket back; worker threads run the searches, and
+		finished paths become collectable after the next call to Update, so
+		results always turn up at a known point in the frame.
+
+		Requests that start and end in the same map cells as one that's already
+		waiting share its search, and the workers stop picking up new searches
+		once they've used up the frame's time budget. With no workers, Update
+		runs the searches itself, still within the budget.
+
+		Every worker has a NavigationSearch of its own, so they all search
+		the map at the same time.
+		*/
+		class PathRequestQueue	{
+		public:
+			PathRequestQueue(NavigationMap& map, int workerCount = 1, float frameBudgetMS = 2.0f);
+			~PathRequestQueue();
+
+			PathTicket			RequestPath(const Vector3& from, const Vector3& to);
+			PathRequestStatus	CollectPath(PathTicket ticket, NavigationPath& outPath);
+
+			//Call once per frame - publishes finished searches and resets the budget
+			void Update();
+
+			void SetFrameBudget(float ms) {
+				frameBudgetMS = ms;
+			}
+
+			float GetFrameBudget() const {
+				return frameBudgetMS;
+			}
+
+		protected:
+			struct PathJob {
+				Vector3		from;
+				Vector3		to;
+				int			startCell;
+				int			endCell;
+				bool		found;
+				NavigationPath			path;
+				std::vector<PathTicket> tickets;
+			};
+
+			struct PathResult {
+				bool			found;
+				NavigationPath	path;
+			};
+
+			void	WorkerThread();
+			void	RunJob(PathJob* job, NavigationSearch& search);
+			void	FinishJob(PathJob* job);
+
+			NavigationMap&		map;
+			NavigationSearch*	updateSearch;	//for Update to use when there's no workers
+
+			std::mutex				queueMutex;
+			std::condition_variable queueReady;
+
+			std::deque<PathJob*>	pendingJobs;
+			std::map<std::pair<int, int>, PathJob*> jobsByCell;	//pending or in flight
+			std::vector<PathJob*>	finishedJobs;
+
+			//Only touched from the game thread
+			std::set<PathTicket>				outstandingTickets;
+			std::map<PathTicket, PathResult>	deliveredResults;
+
+			PathTicket	nextTicket;
+			float		frameBudgetMS;
+			float		budgetLeftMS;	//guarded by queueMutex
+
+			std::atomic<bool>			threadAlive;
+			std::vector<std::thread>	workers;
+		};
+	}
+}
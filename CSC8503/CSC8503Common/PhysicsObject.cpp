@@ -1,6 +1,8 @@
 #include "PhysicsObject.h"
 #include "PhysicsSystem.h"
 #include "../CSC8503Common/Transform.h"
+#include "../../Common/MathsBatch.h"
+#include <algorithm>
 using namespace NCL;
 using namespace CSC8503;
 
@@ -17,6 +19,27 @@ PhysicsObject::~PhysicsObject()	{
 
 }
 
+void* PhysicsObject::operator new(size_t size) {
+	if (size != sizeof(PhysicsObject)) {
+		return ::operator new(size);
+	}
+	return GetPool().Allocate();
+}
+
+void PhysicsObject::operator delete(void* p) {
+	if (GetPool().Owns(p)) {
+		GetPool().Free(p);
+	}
+	else {
+		::operator delete(p);
+	}
+}
+
+ObjectPool<PhysicsObject>& PhysicsObject::GetPool() {
+	static ObjectPool<PhysicsObject> pool;
+	return pool;
+}
+
 void PhysicsObject::ApplyAngularImpulse(const Vector3& force) {
 	angularVelocity += inverseInteriaTensor * force;
 }
@@ -68,4 +91,26 @@ void PhysicsObject::UpdateInertiaTensor() {
 	Matrix3 orientation		= q.ToMatrix3();
 
 	inverseInteriaTensor = orientation * Matrix3::Scale(inverseInertia) *invOrientation;
+}
+
+const size_t TENSOR_BATCH_SIZE = 64; //small enough to live on the stack
+
+void PhysicsObject::UpdateInertiaTensors(PhysicsObject* const* objects, size_t count) {
+	Quaternion	orientations[TENSOR_BATCH_SIZE];
+	Vector3		inertias[TENSOR_BATCH_SIZE];
+	Matrix3		tensors[TENSOR_BATCH_SIZE];
+
+	for (size_t start = 0; start < count; start += TENSOR_BATCH_SIZE) {
+		size_t batchCount = std::min(count - start, TENSOR_BATCH_SIZE);
+
+		for (size_t i = 0; i < batchCount; ++i) {
+			orientations[i]	= objects[start + i]->transform->GetWorldOrientation();
+			inertias[i]		= objects[start + i]->inverseInertia;
+		}
+		Batch::InverseInertiaTensors(orientations, inertias, tensors, batchCount);
+
+		for (size_t i = 0; i < batchCount; ++i) {
+			objects[start + i]->inverseInteriaTensor = tensors[i];
+		}
+	}
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include "../../Common/Vector3.h"
 #include "../../Common/Matrix3.h"
+#include "../../Common/ObjectPool.h"
 
 using namespace NCL::Maths;
 
@@ -15,6 +16,12 @@ namespace NCL {
 			PhysicsObject(Transform* parentTransform, const CollisionVolume* parentVolume);
 			~PhysicsObject();
 
+			//From a pool, so they're recycled, and sit next to each other
+			static void* operator new(size_t size);
+			static void operator delete(void* p);
+
+			static ObjectPool<PhysicsObject>& GetPool();
+
 			Vector3 GetLinearVelocity() const {
 				return linearVelocity;
 			}
@@ -64,6 +71,9 @@ namespace NCL {
 
 			void UpdateInertiaTensor();
 
+			//The same as UpdateInertiaTensor on each, but done together, with Batch::InverseInertiaTensors
+			static void UpdateInertiaTensors(PhysicsObject* const* objects, size_t count);
+
 			Matrix3 GetInertiaTensor() const {
 				return inverseInteriaTensor;
 			}
@@ -8,6 +8,7 @@
 
 #include "Debug.h"
 
+#include <algorithm>
 #include <functional>
 using namespace NCL;
 using namespace CSC8503;
@@ -22,6 +23,10 @@ and the forces that are added to objects to change those positions
 const float PhysicsSystem::UNIT_MULTIPLIER = 1.0f; // 100.0f
 const float PhysicsSystem::UNIT_RECIPROCAL = 1.0f; //    / UNIT_MULTIPLIER;
 
+//Shared by Update and PredictObject, so that a replayed object moves exactly as it did the first time
+const float	ITERATION_DT				= 1.0f / 240.0f;
+const int	CONSTRAINT_ITERATION_COUNT	= 10;
+
 PhysicsSystem::PhysicsSystem(GameWorld& g) : gameWorld(g) {
 	applyGravity = false;
 	useBroadPhase = false;
@@ -59,7 +64,7 @@ This is the core of the physics engine update
 
 */
 void PhysicsSystem::Update(float dt) {
-	const float iterationDt = 1.0f / 240.0f; //Ideally we'll have 120 physics updates a second 
+	const float iterationDt = ITERATION_DT; //Ideally we'll have 120 physics updates a second 
 	dTOffset += dt; //We accumulate time delta here - there might be remainders from previous frame!
 
 	int iterationCount = (int)(dTOffset / iterationDt); //And split it up here
@@ -71,8 +76,11 @@ void PhysicsSystem::Update(float dt) {
 	for (int i = 0; i < iterationCount; ++i) {
 		if (useBroadPhase) {
 			UpdateObjectAABBs();
-			BroadPhase();
-			NarrowPhase();
+
+			broadphaseArena.Reset(); //last substep's pairs are long gone
+			CollisionPairs pairs(&broadphaseArena);
+			BroadPhase(pairs);
+			NarrowPhase(pairs);
 		}
 		else {
 			BasicCollisionDetection();
@@ -82,7 +90,7 @@ void PhysicsSystem::Update(float dt) {
 		//we just run things multiple times, slowly moving things forward
 		//and then rechecking that the constraints have been met
 
-		int constraintIterationCount = 10;
+		int constraintIterationCount = CONSTRAINT_ITERATION_COUNT;
 		float constraintDt = subDt / (float)constraintIterationCount;
 
 		for (int i = 0; i < constraintIterationCount; ++i) {
@@ -96,6 +104,47 @@ void PhysicsSystem::Update(float dt) {
 	UpdateCollisionList(); //Remove any old collisions
 }
 
+void PhysicsSystem::PredictObject(GameObject& object, float dt) {
+	if (object.GetPhysicsObject() == nullptr) {
+		return;
+	}
+	//Same steps Update would take for a single dt, minus the leftover time
+	int iterationCount = std::max(1, (int)((dt / ITERATION_DT) + 0.5f));
+	float subDt = dt / (float)iterationCount;
+
+	object.GetPhysicsObject()->UpdateInertiaTensor();
+	IntegrateObjectAccel(object, dt);
+
+	std::vector<GameObject*>::const_iterator first;
+	std::vector<GameObject*>::const_iterator last;
+	gameWorld.GetObjectIterators(first, last);
+
+	for (int i = 0; i < iterationCount; ++i) {
+		for (auto j = first; j != last; ++j) {
+			if (*j == &object || (*j)->GetPhysicsObject() == nullptr) {
+				continue;
+			}
+			CollisionDetection::CollisionInfo info;
+			if (CollisionDetection::ObjectIntersection(&object, *j, info)) {
+				ImpulseResolveCollision(*info.a, *info.b, info.point, &object); //the rest of the world has already been simulated
+			}
+		}
+		IntegrateObjectVelocity(object, subDt / (float)CONSTRAINT_ITERATION_COUNT);
+	}
+	object.GetPhysicsObject()->ClearForces();
+}
+
+void PhysicsSystem::RemoveCollisions(GameObject* o) {
+	for (auto i = allCollisions.begin(); i != allCollisions.end(); ) {
+		if (i->a == o || i->b == o) {
+			i = allCollisions.erase(i);
+		}
+		else {
+			++i;
+		}
+	}
+}
+
 /*
 Later on we're going to need to keep track of collisions
 across multiple frames, so we store them in a set.
@@ -174,7 +223,7 @@ In tutorial 5, we start determining the correct response to a collision,
 so that objects separate back out.
 
 */
-void PhysicsSystem::ImpulseResolveCollision(GameObject& a, GameObject& b, CollisionDetection::ContactPoint& p) const {
+void PhysicsSystem::ImpulseResolveCollision(GameObject& a, GameObject& b, CollisionDetection::ContactPoint& p, const GameObject* onlyMove) const {
 
 	PhysicsObject* physA = a.GetPhysicsObject();
 	PhysicsObject* physB = b.GetPhysicsObject();
@@ -182,16 +231,22 @@ void PhysicsSystem::ImpulseResolveCollision(GameObject& a, GameObject& b, Collis
 	Transform& transformA = a.GetTransform();
 	Transform& transformB = b.GetTransform();
 
-	float totalMass = physA->GetInverseMass() + physB->GetInverseMass();
+	bool moveA = !onlyMove || onlyMove == &a;
+	bool moveB = !onlyMove || onlyMove == &b;
+
+	float inverseMassA = moveA ? physA->GetInverseMass() : 0.0f;
+	float inverseMassB = moveB ? physB->GetInverseMass() : 0.0f;
+
+	float totalMass = inverseMassA + inverseMassB;
 
 	if (totalMass == 0.0f) {
 		return;
 	}
 
 	//separate them out using projection
-	transformA.SetWorldPosition(transformA.GetWorldPosition() - (p.normal * p.penetration *(physA->GetInverseMass() / totalMass)));
+	transformA.SetWorldPosition(transformA.GetWorldPosition() - (p.normal * p.penetration *(inverseMassA / totalMass)));
 
-	transformB.SetWorldPosition(transformB.GetWorldPosition() + (p.normal * p.penetration *(physB->GetInverseMass() / totalMass)));
+	transformB.SetWorldPosition(transformB.GetWorldPosition() + (p.normal * p.penetration *(inverseMassB / totalMass)));
 
 	Vector3 relativeA = p.position - transformA.GetWorldPosition();
 	Vector3 relativeB = p.position - transformB.GetWorldPosition();
@@ -211,8 +266,8 @@ void PhysicsSystem::ImpulseResolveCollision(GameObject& a, GameObject& b, Collis
 	}
 
 	//now to work out the effect of inertia
-	Vector3 inertiaA = Vector3::Cross(physA->GetInertiaTensor()*Vector3::Cross(relativeA, p.normal), relativeA);
-	Vector3 inertiaB = Vector3::Cross(physB->GetInertiaTensor()*Vector3::Cross(relativeB, p.normal), relativeB);
+	Vector3 inertiaA = moveA ? Vector3::Cross(physA->GetInertiaTensor()*Vector3::Cross(relativeA, p.normal), relativeA) : Vector3();
+	Vector3 inertiaB = moveB ? Vector3::Cross(physB->GetInertiaTensor()*Vector3::Cross(relativeB, p.normal), relativeB) : Vector3();
 
 	float angularEffect = Vector3::Dot(inertiaA + inertiaB, p.normal);
 	float cResitution = 0.66f; // disperse some kinectic energy
@@ -220,11 +275,14 @@ void PhysicsSystem::ImpulseResolveCollision(GameObject& a, GameObject& b, Collis
 
 	Vector3 fullImpulse = p.normal*j;
 
-	physA->ApplyLinearImpulse(-fullImpulse);
-	physB->ApplyLinearImpulse(fullImpulse);
-
-	physA->ApplyAngularImpulse(Vector3::Cross(relativeA, -fullImpulse));
-	physB->ApplyAngularImpulse(Vector3::Cross(relativeB, fullImpulse));
+	if (moveA) {
+		physA->ApplyLinearImpulse(-fullImpulse);
+		physA->ApplyAngularImpulse(Vector3::Cross(relativeA, -fullImpulse));
+	}
+	if (moveB) {
+		physB->ApplyLinearImpulse(fullImpulse);
+		physB->ApplyAngularImpulse(Vector3::Cross(relativeB, fullImpulse));
+	}
 }
 
 /*
@@ -235,9 +293,8 @@ split the world up using an acceleration structure, so that we can only
 compare the collisions that we absolutely need to.
 
 */
-void PhysicsSystem::BroadPhase() {
-	broadphaseCollisions.clear();
-	QuadTree<GameObject*>tree(Vector2(1024, 1024), 7, 5);
+void PhysicsSystem::BroadPhase(CollisionPairs& pairs) {
+	QuadTree<GameObject*>tree(Vector2(1024, 1024), 7, 5, &broadphaseArena);
 
 	std::vector<GameObject*>::const_iterator first;
 	std::vector<GameObject*>::const_iterator last;
@@ -251,7 +308,7 @@ void PhysicsSystem::BroadPhase() {
 		Vector3 pos = (*i)->GetConstTransform().GetWorldPosition();
 		tree.Insert(*i, pos, halfSizes);
 	}
-	tree.OperateOnContents([&](std::list<QuadTreeEntry<GameObject*>>& data) {
+	tree.OperateOnContents([&](QuadTree<GameObject*>::EntryList& data) {
 		CollisionDetection::CollisionInfo info;
 		
 
@@ -262,7 +319,7 @@ void PhysicsSystem::BroadPhase() {
 				
 				info.a = min((*i).object, (*j).object);
 				info.b = max((*i).object, (*j).object);
-				broadphaseCollisions.insert(info);
+				pairs.insert(info);
 			}
 		}
 	});
@@ -274,8 +331,8 @@ void PhysicsSystem::BroadPhase() {
 The broadphase will now only give us likely collisions, so we can now go through them,
 and work out if they are truly colliding, and if so, add them into the main collision list
 */
-void PhysicsSystem::NarrowPhase() {
-	for (std::set<CollisionDetection::CollisionInfo>::iterator i = broadphaseCollisions.begin(); i != broadphaseCollisions.end(); ++i) {
+void PhysicsSystem::NarrowPhase(const CollisionPairs& pairs) {
+	for (CollisionPairs::const_iterator i = pairs.begin(); i != pairs.end(); ++i) {
 		CollisionDetection::CollisionInfo info = *i;
 		if (CollisionDetection::ObjectIntersection(info.a, info.b, info)) {
 			info.framesLeft = numCollisionFrames;
@@ -299,36 +356,45 @@ void PhysicsSystem::IntegrateAccel(float dt) {
 	std::vector<GameObject*>::const_iterator last;
 	gameWorld.GetObjectIterators(first, last);
 
+	inertiaObjects.clear();
 	for (auto i = first; i != last; ++i) {
-		PhysicsObject* object = (*i)->GetPhysicsObject();
-		if (object == nullptr) {
-			continue; // No physics object for this GameObject!
+		if ((*i)->GetPhysicsObject()) {
+			inertiaObjects.emplace_back((*i)->GetPhysicsObject());
 		}
-		float inverseMass = object->GetInverseMass();
+	}
+	PhysicsObject::UpdateInertiaTensors(inertiaObjects.data(), inertiaObjects.size()); //update tensors vs orientation
 
-		Vector3 linearVel = object->GetLinearVelocity();
-		Vector3 force = object->GetForce();
-		Vector3 accel = force * inverseMass;
+	for (auto i = first; i != last; ++i) {
+		IntegrateObjectAccel(**i, dt);
+	}
+}
 
-		if (applyGravity && inverseMass > 0 && !object->Denygravity()) {
-			accel += gravity; //don't move infinitely heavy things
-		}
+void PhysicsSystem::IntegrateObjectAccel(GameObject& o, float dt) {
+	PhysicsObject* object = o.GetPhysicsObject();
+	if (object == nullptr) {
+		return; // No physics object for this GameObject!
+	}
+	float inverseMass = object->GetInverseMass();
 
-		linearVel += accel * dt; // integrate accel!
-		object->SetLinearVelocity(linearVel);
+	Vector3 linearVel = object->GetLinearVelocity();
+	Vector3 force = object->GetForce();
+	Vector3 accel = force * inverseMass;
 
-		//Angular stuff
-		Vector3 torque = object->GetTorque();
-		Vector3 angVel = object->GetAngularVelocity();
+	if (applyGravity && inverseMass > 0 && !object->Denygravity()) {
+		accel += gravity; //don't move infinitely heavy things
+	}
 
-		object->UpdateInertiaTensor(); // update tensor vs orientation
+	linearVel += accel * dt; // integrate accel!
+	object->SetLinearVelocity(linearVel);
 
-		Vector3 angAccel = object->GetInertiaTensor()*torque;
+	//Angular stuff
+	Vector3 torque = object->GetTorque();
+	Vector3 angVel = object->GetAngularVelocity();
 
-		angVel += angAccel * dt; //intergrate angular accel!
-		object->SetAngularVelocity(angVel);
-	}
+	Vector3 angAccel = object->GetInertiaTensor()*torque;
 
+	angVel += angAccel * dt; //intergrate angular accel!
+	object->SetAngularVelocity(angVel);
 }
 /*
 This function integrates linear and angular velocity into
@@ -340,39 +406,43 @@ void PhysicsSystem::IntegrateVelocity(float dt) {
 	std::vector<GameObject*>::const_iterator first;
 	std::vector<GameObject*>::const_iterator last;
 	gameWorld.GetObjectIterators(first, last);
-	float dampingFactor = 1.0f - 0.95f;
-	float frameDamping = powf(dampingFactor, dt);
 
 	for (auto i = first; i != last; ++i) {
-		PhysicsObject* object = (*i)->GetPhysicsObject();
-		if (object == nullptr) {
-			continue;
-		}
-		Transform&transform = (*i)->GetTransform();
-		//Position Stuff
-		Vector3 position = transform.GetLocalPosition();
-		Vector3 linearVel = object->GetLinearVelocity();
-		position += linearVel * dt;
-		transform.SetLocalPosition(position);
-		transform.SetWorldPosition(position);
-		//Linear Damping
-		linearVel = linearVel * frameDamping;
-		object->SetLinearVelocity(linearVel);
-
-		//Orienttation Stuff
-		Quaternion orientation = transform.GetLocalOrientation();
-		Vector3 angVel = object->GetAngularVelocity();
-
-		orientation = orientation + (Quaternion(angVel*dt*0.5f, 0.0f)*orientation);
-		orientation.Normalise();
-
-		transform.SetLocalOrientation(orientation);
-
-		//Damp the angular velocity too
-		angVel = angVel * frameDamping;
-		object->SetAngularVelocity(angVel);
+		IntegrateObjectVelocity(**i, dt);
 	}
+}
 
+void PhysicsSystem::IntegrateObjectVelocity(GameObject& o, float dt) {
+	float dampingFactor = 1.0f - 0.95f;
+	float frameDamping = powf(dampingFactor, dt);
+
+	PhysicsObject* object = o.GetPhysicsObject();
+	if (object == nullptr) {
+		return;
+	}
+	Transform&transform = o.GetTransform();
+	//Position Stuff
+	Vector3 position = transform.GetLocalPosition();
+	Vector3 linearVel = object->GetLinearVelocity();
+	position += linearVel * dt;
+	transform.SetLocalPosition(position);
+	transform.SetWorldPosition(position);
+	//Linear Damping
+	linearVel = linearVel * frameDamping;
+	object->SetLinearVelocity(linearVel);
+
+	//Orienttation Stuff
+	Quaternion orientation = transform.GetLocalOrientation();
+	Vector3 angVel = object->GetAngularVelocity();
+
+	orientation = orientation + (Quaternion(angVel*dt*0.5f, 0.0f)*orientation);
+	orientation.Normalise();
+
+	transform.SetLocalOrientation(orientation);
+
+	//Damp the angular velocity too
+	angVel = angVel * frameDamping;
+	object->SetAngularVelocity(angVel);
 }
 
 /*
@@ -413,8 +483,7 @@ void PhysicsSystem::UpdateObjectAABBs() {
 	std::vector < GameObject * >::const_iterator first;
 	std::vector < GameObject * >::const_iterator last;
 	gameWorld.GetObjectIterators(first, last);
-	for (auto i = first; i != last; ++i) {
-		(*i)->UpdateBroadphaseAABB();
-
+	if (first != last) {
+		GameObject::UpdateBroadphaseAABBs(&*first, last - first);
 	}
 }
\ No newline at end of file
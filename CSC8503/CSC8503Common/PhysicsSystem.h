@@ -1,9 +1,13 @@
 #pragma once
 #include "../CSC8503Common/GameWorld.h"
+#include "../../Common/FrameArena.h"
 #include <set>
+#include <vector>
 
 namespace NCL {
 	namespace CSC8503 {
+		class PhysicsObject;
+
 		class PhysicsSystem {
 		public:
 			PhysicsSystem(GameWorld& g);
@@ -13,6 +17,18 @@ namespace NCL {
 
 			void Update(float dt);
 
+			/*
+			Moves a single object on by dt, colliding it against the rest of
+			the world, for a client replaying its own inputs after the server
+			has corrected it. Nothing else is integrated or pushed about -
+			everything it hits is treated as immovable - and the collision
+			list isn't touched, so replays don't cause any collision callbacks.
+			*/
+			void PredictObject(GameObject& object, float dt);
+
+			//Forgets every collision involving o - call before deleting it mid-level
+			void RemoveCollisions(GameObject* o);
+
 			void UseGravity(bool state) {
 				applyGravity = state;
 			}
@@ -23,27 +39,46 @@ namespace NCL {
 
 			void SetGravity(const Vector3& g);
 
+			//Off unless asked for - the golf game's goal and reset checks are only
+			//in BasicCollisionDetection, so it never turns the broadphase on
+			void UseBroadPhase(bool state) {
+				useBroadPhase = state;
+			}
+
+			//Where the broadphase builds its quadtree and pair list each substep.
+			//Untouched while the broadphase is off
+			const FrameArena& GetBroadPhaseArena() const {
+				return broadphaseArena;
+			}
+
 			static const float UNIT_MULTIPLIER;
 			static const float UNIT_RECIPROCAL;
 			bool reachedGoal;
 			bool resetlevel;
 
 		protected:
+			typedef std::set<CollisionDetection::CollisionInfo, std::less<CollisionDetection::CollisionInfo>,
+				FrameAllocator<CollisionDetection::CollisionInfo>> CollisionPairs;
+
 			void BasicCollisionDetection();
-			void BroadPhase();
-			void NarrowPhase();
+			void BroadPhase(CollisionPairs& pairs);
+			void NarrowPhase(const CollisionPairs& pairs);
 
 			void ClearForces();
 
 			void IntegrateAccel(float dt);
 			void IntegrateVelocity(float dt);
 
+			void IntegrateObjectAccel(GameObject& o, float dt);
+			void IntegrateObjectVelocity(GameObject& o, float dt);
+
 			void UpdateConstraints(float dt);
 
 			void UpdateCollisionList();
 			void UpdateObjectAABBs();
 
-			void ImpulseResolveCollision(GameObject& a, GameObject&b, CollisionDetection::ContactPoint& p) const;
+			//If onlyMove is set, the other object is treated as having infinite mass, and left alone
+			void ImpulseResolveCollision(GameObject& a, GameObject&b, CollisionDetection::ContactPoint& p, const GameObject* onlyMove = nullptr) const;
 
 			GameWorld& gameWorld;
 
@@ -53,8 +88,9 @@ namespace NCL {
 			float	globalDamping;
 
 			std::set<CollisionDetection::CollisionInfo> allCollisions;
-			std::set<CollisionDetection::CollisionInfo> broadphaseCollisions;
-			bool useBroadPhase = true;
+			std::vector<PhysicsObject*>	inertiaObjects;	//gathered up every IntegrateAccel, kept so it doesn't reallocate
+			FrameArena	broadphaseArena;	//emptied at the start of every substep
+			bool useBroadPhase = false;
 			int numCollisionFrames = 5;
 		};
 	}
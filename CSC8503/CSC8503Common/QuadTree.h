@@ -1,5 +1,6 @@
 #pragma once
 #include "../../Common/Vector2.h"
+#include "../../Common/FrameArena.h"
 #include "Debug.h"
 #include <list>
 #include <functional>
@@ -26,23 +27,31 @@ namespace NCL {
 		template<class T>
 		class QuadTreeNode {
 		public:
-			typedef std::function<void(std::list<QuadTreeEntry<T>>&)> QuadTreeFunc;
+			typedef std::list<QuadTreeEntry<T>, FrameAllocator<QuadTreeEntry<T>>> EntryList;
+			typedef std::function<void(EntryList&)> QuadTreeFunc;
 		protected:
 			friend class QuadTree<T>;
 
-			QuadTreeNode() {
-			}
-
-			QuadTreeNode(Vector2 pos, Vector2 size) {
+			QuadTreeNode(Vector2 pos, Vector2 size, FrameArena* arena)
+				: contents(FrameAllocator<QuadTreeEntry<T>>(arena)) {
 				children = nullptr;
 				this->position = pos;
 				this->size = size;
+				this->arena = arena;
 			}
 
 			~QuadTreeNode() {
-				delete[] children;
+				if (children) {
+					for (int i = 0; i < 4; ++i) {
+						children[i].~QuadTreeNode();
+					}
+					FrameAllocator<QuadTreeNode<T>>(arena).deallocate(children, 4);
+				}
 			}
 
+			QuadTreeNode(const QuadTreeNode&) = delete;
+			QuadTreeNode& operator=(const QuadTreeNode&) = delete;
+
 			void Insert(T& object, const Vector3& objectPos, const Vector3& objectSize, int depthLeft, int maxSize) {
 				if (!CollisionDetection::AABBTest(objectPos, Vector3(position.x, 0, position.y), objectSize, Vector3(size.x, 1000.0f, size.y))) {
 					return;
@@ -73,11 +82,11 @@ namespace NCL {
 
 			void Split() {
 				Vector2 halfSize = size / 2.0f;
-				children = new QuadTreeNode <T >[4];
-				children[0] = QuadTreeNode <T >(position + Vector2(-halfSize.x, halfSize.y), halfSize);
-				children[1] = QuadTreeNode <T >(position + Vector2(halfSize.x, halfSize.y), halfSize);
-				children[2] = QuadTreeNode <T >(position + Vector2(-halfSize.x, -halfSize.y), halfSize);
-				children[3] = QuadTreeNode <T >(position + Vector2(halfSize.x, -halfSize.y), halfSize);
+				children = FrameAllocator<QuadTreeNode<T>>(arena).allocate(4);
+				new (&children[0]) QuadTreeNode<T>(position + Vector2(-halfSize.x, halfSize.y), halfSize, arena);
+				new (&children[1]) QuadTreeNode<T>(position + Vector2(halfSize.x, halfSize.y), halfSize, arena);
+				new (&children[2]) QuadTreeNode<T>(position + Vector2(-halfSize.x, -halfSize.y), halfSize, arena);
+				new (&children[3]) QuadTreeNode<T>(position + Vector2(halfSize.x, -halfSize.y), halfSize, arena);
 			}
 
 
@@ -97,13 +106,32 @@ namespace NCL {
 				}
 			}
 
+			//Only visits the leaves overlapping the given box - objects spanning
+			//several leaves will be seen more than once!
+			void OperateOnRegion(const Vector3& regionPos, const Vector3& regionSize, QuadTreeFunc& func) {
+				if (!CollisionDetection::AABBTest(regionPos, Vector3(position.x, 0, position.y), regionSize, Vector3(size.x, 1000.0f, size.y))) {
+					return;
+				}
+				if (children) {
+					for (int i = 0; i < 4; ++i) {
+						children[i].OperateOnRegion(regionPos, regionSize, func);
+					}
+				}
+				else {
+					if (!contents.empty()) {
+						func(contents);
+					}
+				}
+			}
+
 		protected:
-			std::list<QuadTreeEntry<T>>	contents;
+			EntryList	contents;
 
 			Vector2 position;
 			Vector2 size;
 
 			QuadTreeNode<T>* children;
+			FrameArena*		 arena;	//where the children and contents live, or null for the heap
 		};
 	}
 }
@@ -112,11 +140,18 @@ namespace NCL {
 namespace NCL {
 	using namespace NCL::Maths;
 	namespace CSC8503 {
+		/*
+		Given an arena, every node and entry is allocated from it, which is
+		much quicker for a tree that's built from scratch each frame - but the
+		tree has to be gone before the arena's Reset.
+		*/
 		template<class T>
 		class QuadTree {
 		public:
-			QuadTree(Vector2 size, int maxDepth = 6, int maxSize = 5)
-				: root(QuadTreeNode<T>(Vector2(), size)) {
+			typedef typename QuadTreeNode<T>::EntryList EntryList;
+
+			QuadTree(Vector2 size, int maxDepth = 6, int maxSize = 5, FrameArena* arena = nullptr)
+				: root(Vector2(), size, arena) {
 				this->maxDepth = maxDepth;
 				this->maxSize = maxSize;
 			}
@@ -134,6 +169,10 @@ namespace NCL {
 				root.OperateOnContents(func);
 			}
 
+			void OperateOnRegion(const Vector3& pos, const Vector3& size, typename QuadTreeNode<T>::QuadTreeFunc func) {
+				root.OperateOnRegion(pos, size, func);
+			}
+
 		protected:
 			QuadTreeNode<T> root;
 			int maxDepth;
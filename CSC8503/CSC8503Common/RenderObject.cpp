@@ -14,4 +14,25 @@ RenderObject::RenderObject(Transform* parentTransform, MeshGeometry* mesh, Textu
 
 RenderObject::~RenderObject() {
 
+}
+
+void* RenderObject::operator new(size_t size) {
+	if (size != sizeof(RenderObject)) {
+		return ::operator new(size);
+	}
+	return GetPool().Allocate();
+}
+
+void RenderObject::operator delete(void* p) {
+	if (GetPool().Owns(p)) {
+		GetPool().Free(p);
+	}
+	else {
+		::operator delete(p);
+	}
+}
+
+ObjectPool<RenderObject>& RenderObject::GetPool() {
+	static ObjectPool<RenderObject> pool;
+	return pool;
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "../../Common/Matrix4.h"
 #include "../../Common/TextureBase.h"
 #include "../../Common/ShaderBase.h"
+#include "../../Common/ObjectPool.h"
 
 namespace NCL {
 	using namespace NCL::Rendering;
@@ -16,6 +17,12 @@ namespace NCL {
 			RenderObject(Transform* parentTransform, MeshGeometry* mesh, TextureBase* tex, ShaderBase* shader);
 			~RenderObject();
 
+			//From a pool, so they're recycled, and sit next to each other
+			static void* operator new(size_t size);
+			static void operator delete(void* p);
+
+			static ObjectPool<RenderObject>& GetPool();
+
 			void SetDefaultTexture(TextureBase* t) {
 				texture = t;
 			}
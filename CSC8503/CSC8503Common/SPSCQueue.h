@@ -0,0 +1,66 @@
+#pragma once
+#include <atomic>
+#include <vector>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		Bounded queue for passing things from exactly one thread to exactly
+		one other, without locking. The producer only ever writes tail, and
+		the consumer only ever writes head, so each side just has to see the
+		other's latest value - Push fails when the queue's full, and Pop
+		fails when it's empty, rather than either of them waiting.
+		*/
+		template <class T>
+		class SPSCQueue	{
+		public:
+			SPSCQueue(size_t minCapacity) {
+				size_t capacity = 1;
+				while (capacity < minCapacity + 1) { //one slot is always left empty
+					capacity <<= 1;
+				}
+				items.resize(capacity);
+				mask = capacity - 1;
+				head = 0;
+				tail = 0;
+			}
+
+			//Producer thread only
+			bool Push(const T& item) {
+				size_t currentTail	= tail.load(std::memory_order_relaxed);
+				size_t nextTail		= (currentTail + 1) & mask;
+
+				if (nextTail == head.load(std::memory_order_acquire)) {
+					return false; //full!
+				}
+				items[currentTail] = item;
+				tail.store(nextTail, std::memory_order_release);
+				return true;
+			}
+
+			//Consumer thread only
+			bool Pop(T& item) {
+				size_t currentHead = head.load(std::memory_order_relaxed);
+
+				if (currentHead == tail.load(std::memory_order_acquire)) {
+					return false; //empty!
+				}
+				item = items[currentHead];
+				head.store((currentHead + 1) & mask, std::memory_order_release);
+				return true;
+			}
+
+		protected:
+			std::vector<T>	items;
+			size_t			mask;
+
+			//Kept on separate cache lines, so the two threads aren't
+			//constantly stealing the same line off each other
+			char				padding0[64];
+			std::atomic<size_t>	head;
+			char				padding1[64];
+			std::atomic<size_t>	tail;
+			char				padding2[64];
+		};
+	}
+}
@@ -0,0 +1,226 @@
+#include "SnapshotCompressor.h"
+#include "NetworkObject.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+using namespace NCL;
+using namespace CSC8503;
+
+const int MIN_MATCH		= 4;
+const int MAX_MATCH		= 0x7F + MIN_MATCH;
+const int MAX_LITERALS	= 0x80;
+const int MAX_DISTANCE	= 0xFFFF;
+const int HASH_BITS		= 12;
+const int MAX_CHAIN		= 16;	//candidates tried per position - more finds longer matches, slowly
+
+static unsigned int HashPosition(const unsigned char* data) {
+	uint32_t value;
+	memcpy(&value, data, sizeof(value));
+	return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+template <class T> static void AppendValue(std::vector<unsigned char>& data, const T& value) {
+	const unsigned char* bytes = (const unsigned char*)&value;
+	data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+static void AppendHeader(std::vector<unsigned char>& data, short type, int size) {
+	AppendValue(data, (short)size);
+	AppendValue(data, type);
+}
+
+SnapshotCompressor::SnapshotCompressor() {
+	BuildDictionary();
+
+	window = dictionary;
+	dictionaryHeads.assign(1 << HASH_BITS, -1);
+	chain.resize(dictionary.size());
+
+	for (int i = 0; i < (int)dictionary.size(); ++i) {
+		InsertPosition(i, (int)dictionary.size(), dictionaryHeads);
+	}
+}
+
+SnapshotCompressor::~SnapshotCompressor() {
+}
+
+/*
+Only values and headers go in - never whole structs, as their padding and
+the NetworkState vtable pointer aren't the same in every process. Things
+that turn up most often go last, so they're the closest matches.
+*/
+void SnapshotCompressor::BuildDictionary() {
+	dictionary.clear();
+	dictionary.insert(dictionary.end(), 8, 0xFF);
+
+	ClientPacket client;
+	AppendHeader(dictionary, client.type, client.size);
+	AppendValue(dictionary, client.lastID);
+	dictionary.insert(dictionary.end(), sizeof(client.buttonstates), 0);
+
+	for (int i = 0; i <= (int)sizeof(DeltaPacket::data); ++i) {
+		DeltaPacket delta;
+		delta.SetDataSize(i);
+		AppendHeader(dictionary, delta.type, delta.size);
+	}
+	dictionary.insert(dictionary.end(), 32, 0);
+
+	AppendValue(dictionary, 0.0f);
+	AppendValue(dictionary, 0.0f);
+	AppendValue(dictionary, 0.0f);
+	AppendValue(dictionary, 1.0f); //identity orientation
+
+	SnapshotPacket full(0, true);
+	SnapshotPacket delta(0, false);
+	AppendHeader(dictionary, full.type, full.size);
+	AppendValue(dictionary, full.fullFrame);
+	AppendHeader(dictionary, delta.type, delta.size);
+	AppendValue(dictionary, delta.fullFrame);
+
+	FullPacket state;
+	AppendHeader(dictionary, state.type, state.size);
+}
+
+void SnapshotCompressor::InsertPosition(int position, int end, std::vector<int>& hashHeads) {
+	if (position + MIN_MATCH > end) {
+		return;
+	}
+	unsigned int hash	= HashPosition(&window[position]);
+	chain[position]		= hashHeads[hash];
+	hashHeads[hash]		= position;
+}
+
+bool SnapshotCompressor::WriteLiterals(int from, int to, enet_uint8* outData, size_t& written, size_t outLimit) const {
+	while (from < to) {
+		int count = std::min(to - from, MAX_LITERALS);
+		if (written + 1 + count > outLimit) {
+			return false;
+		}
+		outData[written++] = (enet_uint8)(count - 1);
+		memcpy(outData + written, &window[from], count);
+		written += count;
+		from	+= count;
+	}
+	return true;
+}
+
+size_t SnapshotCompressor::Compress(const ENetBuffer* inBuffers, size_t inBufferCount, size_t inLimit, enet_uint8* outData, size_t outLimit) {
+	window.assign(dictionary.begin(), dictionary.end());
+	for (size_t i = 0; i < inBufferCount && window.size() - dictionary.size() < inLimit; ++i) {
+		const unsigned char* data = (const unsigned char*)inBuffers[i].data;
+		size_t length = std::min(inBuffers[i].dataLength, inLimit - (window.size() - dictionary.size()));
+		window.insert(window.end(), data, data + length);
+	}
+	int start	= (int)dictionary.size();
+	int end		= (int)window.size();
+
+	heads = dictionaryHeads;
+	chain.resize(end);
+
+	size_t	written			= 0;
+	int		literalStart	= start;
+	int		position		= start;
+
+	while (position < end) {
+		int bestLength		= 0;
+		int bestDistance	= 0;
+
+		if (end - position >= MIN_MATCH) {
+			int maxLength	= std::min(MAX_MATCH, end - position);
+			int candidate	= heads[HashPosition(&window[position])];
+
+			for (int tries = 0; candidate >= 0 && position - candidate <= MAX_DISTANCE && tries < MAX_CHAIN; ++tries) {
+				int length = 0;
+				while (length < maxLength && window[candidate + length] == window[position + length]) {
+					++length;
+				}
+				if (length > bestLength) {
+					bestLength		= length;
+					bestDistance	= position - candidate;
+					if (length == maxLength) {
+						break;
+					}
+				}
+				candidate = chain[candidate];
+			}
+		}
+		if (bestLength < MIN_MATCH) {
+			InsertPosition(position, end, heads);
+			++position;
+			continue;
+		}
+		if (!WriteLiterals(literalStart, position, outData, written, outLimit) || written + 3 > outLimit) {
+			return 0;
+		}
+		outData[written++] = (enet_uint8)(0x80 | (bestLength - MIN_MATCH));
+		outData[written++] = (enet_uint8)(bestDistance & 0xFF);
+		outData[written++] = (enet_uint8)(bestDistance >> 8);
+
+		for (int i = 0; i < bestLength; ++i) {
+			InsertPosition(position + i, end, heads);
+		}
+		position		+= bestLength;
+		literalStart	= position;
+	}
+	if (!WriteLiterals(literalStart, end, outData, written, outLimit)) {
+		return 0;
+	}
+	return written;
+}
+
+size_t SnapshotCompressor::Decompress(const enet_uint8* inData, size_t inLimit, enet_uint8* outData, size_t outLimit) {
+	size_t read		= 0;
+	size_t written	= 0;
+
+	while (read < inLimit) {
+		enet_uint8 token = inData[read++];
+
+		if (token < 0x80) {
+			size_t count = token + 1;
+			if (read + count > inLimit || written + count > outLimit) {
+				return 0;
+			}
+			memcpy(outData + written, inData + read, count);
+			read	+= count;
+			written += count;
+			continue;
+		}
+		if (read + 2 > inLimit) {
+			return 0;
+		}
+		size_t length	= (token & 0x7F) + MIN_MATCH;
+		size_t distance = inData[read] | (inData[read + 1] << 8);
+		read += 2;
+
+		if (distance == 0 || distance > written + dictionary.size() || written + length > outLimit) {
+			return 0;
+		}
+		for (size_t i = 0; i < length; ++i, ++written) { //one at a time, as matches can overlap themselves
+			outData[written] = distance > written ?
+				dictionary[dictionary.size() - (distance - written)] : outData[written - distance];
+		}
+	}
+	return written;
+}
+
+static size_t ENET_CALLBACK CompressCallback(void* context, const ENetBuffer* inBuffers, size_t inBufferCount,
+	size_t inLimit, enet_uint8* outData, size_t outLimit) {
+	return ((SnapshotCompressor*)context)->Compress(inBuffers, inBufferCount, inLimit, outData, outLimit);
+}
+
+static size_t ENET_CALLBACK DecompressCallback(void* context, const enet_uint8* inData, size_t inLimit,
+	enet_uint8* outData, size_t outLimit) {
+	return ((SnapshotCompressor*)context)->Decompress(inData, inLimit, outData, outLimit);
+}
+
+static void ENET_CALLBACK DestroyCallback(void* context) {
+	delete (SnapshotCompressor*)context;
+}
+
+void SnapshotCompressor::CreateENetCompressor(ENetCompressor& compressor) {
+	compressor.context		= new SnapshotCompressor();
+	compressor.compress		= CompressCallback;
+	compressor.decompress	= DecompressCallback;
+	compressor.destroy		= DestroyCallback;
+}
\ No newline at end of file
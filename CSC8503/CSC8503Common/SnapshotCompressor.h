@@ -0,0 +1,51 @@
+#pragma once
+#include <enet/enet.h>
+#include <vector>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		A small LZ77 compressor for whole ENet datagrams, which is what ENet
+		hands its compressor. Snapshots are mostly the same few packet headers
+		over and over, plus floats that often haven't changed much, so the
+		history is started off with a dictionary of the headers and values we
+		send the most - even a datagram with a single packet in it then has
+		something to match against. Every datagram is compressed on its own,
+		so losing one doesn't stop the next one being read.
+
+		The stream is a series of tokens:
+			0x00 - 0x7F	: that many + 1 literal bytes follow
+			0x80 - 0xFF	: copy (token & 0x7F) + MIN_MATCH bytes from a 16 bit
+						  little endian distance back in the dictionary + output
+
+		Both ends have to be built from the same packet layouts, as the
+		dictionary is made from them.
+		*/
+		class SnapshotCompressor	{
+		public:
+			SnapshotCompressor();
+			~SnapshotCompressor();
+
+			//Same as ENet's compressor callbacks - both return 0 on failure, or
+			//if the data won't fit in outLimit (so ENet sends it uncompressed)
+			size_t Compress(const ENetBuffer* inBuffers, size_t inBufferCount, size_t inLimit, enet_uint8* outData, size_t outLimit);
+			size_t Decompress(const enet_uint8* inData, size_t inLimit, enet_uint8* outData, size_t outLimit);
+
+			//Fills in an ENetCompressor that owns a new SnapshotCompressor, for enet_host_compress
+			static void CreateENetCompressor(ENetCompressor& compressor);
+
+		protected:
+			void	BuildDictionary();
+			void	InsertPosition(int position, int end, std::vector<int>& hashHeads);
+			bool	WriteLiterals(int from, int to, enet_uint8* outData, size_t& written, size_t outLimit) const;
+
+			std::vector<unsigned char>	dictionary;
+			std::vector<int>			dictionaryHeads;	//hash table with just the dictionary in it
+
+			//Scratch space for Compress
+			std::vector<unsigned char>	window;	//dictionary, then the datagram
+			std::vector<int>			heads;	//newest position with each hash, or -1
+			std::vector<int>			chain;	//the position before that with the same hash
+		};
+	}
+}
\ No newline at end of file
@@ -11,6 +11,9 @@ namespace NCL {
 		}
 		~SphereVolume() {}
 
+		using CollisionVolume::operator new;
+		using CollisionVolume::operator delete;
+
 		float GetRadius() const {
 			return radius;
 		}
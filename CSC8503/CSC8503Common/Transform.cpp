@@ -1,34 +1,105 @@
 #include "Transform.h"
 
+#include <algorithm>
+
 using namespace NCL::CSC8503;
 
+std::atomic<unsigned int> Transform::hierarchyVersion(0);
+
 Transform::Transform()	{
 	parent		= nullptr;
 	localScale	= Vector3(1, 1, 1);
+	localDirty	= true;
+	worldDirty	= true;
 }
 
 Transform::Transform(const Vector3& position, Transform* p) {
-	parent = p;
+	parent		= nullptr;
+	localDirty	= true;
+	worldDirty	= true;
+	SetParent(p);
 	SetWorldPosition(position);
 }
 
+Transform::Transform(const Transform& other) {
+	parent				= nullptr;
+	localPosition		= other.localPosition;
+	localScale			= other.localScale;
+	localOrientation	= other.localOrientation;
+	localDirty			= true;
+	worldDirty			= true;
+}
+
+Transform& Transform::operator=(const Transform& other) {
+	if (this != &other) {
+		localPosition		= other.localPosition;
+		localScale			= other.localScale;
+		localOrientation	= other.localOrientation;
+		SetLocalDirty();
+	}
+	return *this;
+}
+
 Transform::~Transform(){
+	SetParent(nullptr);
+	for (Transform* child : children) {
+		child->parent = nullptr;
+		child->SetWorldDirty();
+	}
+	if (!children.empty()) {
+		hierarchyVersion++;
+	}
 }
 
-void Transform::UpdateMatrices() {
-	localMatrix = 
-		Matrix4::Translation(localPosition) * 
-		localOrientation.ToMatrix4() *
-		Matrix4::Scale(localScale);
+void Transform::SetParent(Transform* newParent) {
+	if (newParent == parent) {
+		return;
+	}
+	if (parent) {
+		parent->children.erase(std::remove(parent->children.begin(), parent->children.end(), this), parent->children.end());
+	}
+	parent = newParent;
+	if (parent) {
+		parent->children.emplace_back(this);
+	}
+	hierarchyVersion++;
+	SetWorldDirty();
+}
+
+int Transform::GetDepth() const {
+	int depth = 0;
+	for (const Transform* p = parent; p; p = p->parent) {
+		depth++;
+	}
+	return depth;
+}
+
+void Transform::SetWorldDirty() {
+	if (worldDirty) {
+		return; //so are all of our children, then
+	}
+	worldDirty = true;
+	for (Transform* child : children) {
+		child->SetWorldDirty();
+	}
+}
+
+void Transform::RecalculateMatrices() {
+	if (localDirty) {
+		localMatrix = Matrix4::TRS(localPosition, localOrientation, localScale);
+		localDirty	= false;
+	}
 
 	if (parent) {
-		worldMatrix			= parent->GetWorldMatrix() * localMatrix;
+		parent->UpdateMatrices(); //in case we've been updated out of order
+		worldMatrix			= parent->GetWorldMatrix().AffineMultiply(localMatrix);
 		worldOrientation	= parent->GetWorldOrientation() * localOrientation;
 	}
 	else {
 		worldMatrix			= localMatrix;
 		worldOrientation	= localOrientation;
 	}
+	worldDirty = false;
 }
 
 void Transform::SetWorldPosition(const Vector3& worldPos) {
@@ -44,10 +115,12 @@ void Transform::SetWorldPosition(const Vector3& worldPos) {
 		localPosition = worldPos;
 		worldMatrix.SetPositionVector(worldPos);
 	}
+	SetLocalDirty();
 }
 
 void Transform::SetLocalPosition(const Vector3& localPos) {
 	localPosition = localPos;
+	SetLocalDirty();
 }
 
 void Transform::SetWorldScale(const Vector3& worldScale) {
@@ -56,9 +129,11 @@ void Transform::SetWorldScale(const Vector3& worldScale) {
 	}
 	else {
 		localScale = worldScale;
+		SetLocalDirty();
 	}
 }
 
 void Transform::SetLocalScale(const Vector3& newScale) {
 	localScale = newScale;
+	SetLocalDirty();
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "../../Common/Quaternion.h"
 
 #include <vector>
+#include <atomic>
 
 using std::vector;
 
@@ -11,6 +12,18 @@ using namespace NCL::Maths;
 
 namespace NCL {
 	namespace CSC8503 {
+		/*
+		Matrices are only rebuilt when something has changed since the last
+		UpdateMatrices - setting any part of a transform marks it, and every
+		transform below it in the hierarchy, as dirty. Anything that never
+		moves (most of a level) only pays for its matrices once.
+
+		Parents have to be updated before their children; GameWorld keeps its
+		transforms in depth order so that always happens.
+
+		Parents and children are only ever changed on the main thread - nothing
+		locks the children lists.
+		*/
 		class Transform
 		{
 		public:
@@ -18,6 +31,12 @@ namespace NCL {
 			Transform(const Vector3& position, Transform* parent = nullptr);
 			~Transform();
 
+			//Copies only the local position, scale and orientation - the copy
+			//starts off with no parent and no children of its own, and assigning
+			//leaves a transform wherever it already was in the hierarchy
+			Transform(const Transform& other);
+			Transform& operator=(const Transform& other);
+
 			void SetWorldPosition(const Vector3& worldPos);
 			void SetLocalPosition(const Vector3& localPos);
 
@@ -28,8 +47,24 @@ namespace NCL {
 				return parent;
 			}
 
-			void SetParent(Transform* newParent) {
-				parent = newParent;
+			void SetParent(Transform* newParent);
+
+			const vector<Transform*>& GetChildren() const {
+				return children;
+			}
+
+			//How many parents up the hierarchy goes - 0 for a root
+			int GetDepth() const;
+
+			bool IsDirty() const {
+				return worldDirty;
+			}
+
+			//Bumped whenever any transform's parent changes, so anything keeping
+			//transforms in hierarchy order can tell when to sort them again.
+			//Safe to read from any thread
+			static unsigned int GetHierarchyVersion() {
+				return hierarchyVersion;
 			}
 
 			Matrix4 GetWorldMatrix() const {
@@ -58,6 +93,7 @@ namespace NCL {
 
 			void SetLocalOrientation(const Quaternion& newOr) {
 				localOrientation = newOr;
+				SetLocalDirty();
 			}
 
 			Quaternion GetWorldOrientation() const {
@@ -68,9 +104,23 @@ namespace NCL {
 				return worldOrientation.Conjugate().ToMatrix3();
 			}
 
-			void UpdateMatrices();
+			//Does nothing unless something's changed
+			void UpdateMatrices() {
+				if (worldDirty) {
+					RecalculateMatrices();
+				}
+			}
 
 		protected:
+			void RecalculateMatrices();
+
+			void SetLocalDirty() {
+				localDirty = true;
+				SetWorldDirty();
+			}
+
+			void SetWorldDirty();
+
 			Matrix4		localMatrix;
 			Matrix4		worldMatrix;
 
@@ -82,6 +132,11 @@ namespace NCL {
 			Transform*	parent;
 
 			vector<Transform*> children;
+
+			bool		localDirty;	//localMatrix needs rebuilding, and so does worldMatrix
+			bool		worldDirty;	//worldMatrix needs rebuilding - always set on our children too
+
+			static std::atomic<unsigned int> hierarchyVersion;
 		};
 	}
 }
@@ -40,42 +40,135 @@ GameTechRenderer::GameTechRenderer(GameWorld& world) : OGLRenderer(*Window::GetW
 	lightColour = Vector4(1.0f, 1.0f, 0.5f, 1.0f);
 	lightRadius = 8000.0f;
 	lightPosition = Vector3(-2000.0f, 2500.0f, -2000.0f);
+
+	frame		= nullptr;
+	writeFrame	= 0;
+	readFrame	= 1;
+	latestFrame = 2;
+	renderThreadAlive = false;
 }
 
 GameTechRenderer::~GameTechRenderer()	{
+	SetPipelined(false); //we need the context back to delete anything
 	glDeleteTextures(1, &shadowTex);
 	glDeleteFramebuffers(1, &shadowFBO);
 }
 
+void GameTechRenderer::SetPipelined(bool pipelined) {
+	if (pipelined == IsPipelined()) {
+		return;
+	}
+	if (pipelined) {
+		latestFrame = latestFrame & ~NewFrame; //anything left over from last time is stale
+		renderThreadAlive = true;
+		DetachContext();
+		renderThread = std::thread(&GameTechRenderer::RenderThread, this);
+	}
+	else {
+		{
+			std::lock_guard<std::mutex> lock(frameMutex);
+			renderThreadAlive = false;
+		}
+		frameReady.notify_one();
+		renderThread.join();
+		AttachContext();
+	}
+}
+
+void GameTechRenderer::SubmitFrame() {
+	BuildSnapshot(frames[writeFrame]);
+
+	if (!IsPipelined()) {
+		frame = &frames[writeFrame];
+		Render();
+		return;
+	}
+	writeFrame = latestFrame.exchange(writeFrame | NewFrame) & ~NewFrame;
+	{
+		std::lock_guard<std::mutex> lock(frameMutex); //so the render thread can't miss it while going to sleep
+	}
+	frameReady.notify_one();
+}
+
+void GameTechRenderer::RenderThread() {
+	AttachContext();
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(frameMutex);
+			frameReady.wait(lock, [&] {
+				return !renderThreadAlive || (latestFrame & NewFrame);
+			});
+			if (!renderThreadAlive) {
+				break;
+			}
+		}
+		readFrame	= latestFrame.exchange(readFrame) & ~NewFrame;
+		frame		= &frames[readFrame];
+		Render();
+	}
+	DetachContext();
+}
+
+void GameTechRenderer::BuildSnapshot(FrameSnapshot& snapshot) {
+	BuildObjectList(snapshot);
+	SortObjectList(snapshot);
+
+	Camera* camera = gameWorld.GetMainCamera();
+	float screenAspect = (float)currentWidth / (float)currentHeight;
+
+	snapshot.viewMatrix		= camera->BuildViewMatrix();
+	snapshot.projMatrix		= camera->BuildProjectionMatrix(screenAspect);
+	snapshot.cameraPosition	= camera->GetPosition();
+	snapshot.width			= currentWidth;
+	snapshot.height			= currentHeight;
+
+	//The snapshot takes this frame's debug data, and we take its old storage back to reuse
+	snapshot.debugStrings.clear();
+	snapshot.debugLines.clear();
+	snapshot.debugStrings.swap(debugStrings);
+	snapshot.debugLines.swap(debugLines);
+	snapshot.debugText.Swap(debugText);
+	debugText.Reset();
+}
+
 void GameTechRenderer::RenderFrame() {
 	glEnable(GL_CULL_FACE);
 	glClearColor(1, 1, 1, 1);
-	BuildObjectList();
-	SortObjectList();
 	RenderShadowMap();
 	RenderCamera();
 	glDisable(GL_CULL_FACE); //Todo - text indices are going the wrong way...
 }
 
-void GameTechRenderer::BuildObjectList() {
+void GameTechRenderer::EndFrame() {
+	DrawDebugData(frame->debugStrings, frame->debugLines);
+	SwapBuffers();
+}
+
+void GameTechRenderer::BuildObjectList(FrameSnapshot& snapshot) {
 	std::vector<GameObject*>::const_iterator first;
 	std::vector<GameObject*>::const_iterator last;
 
 	gameWorld.GetObjectIterators(first, last);
 
-	activeObjects.clear();
+	snapshot.objects.clear();
 
 	for (std::vector<GameObject*>::const_iterator i = first; i != last; ++i) {
 		if ((*i)->IsActive()) {
 			const RenderObject*g = (*i)->GetRenderObject();
 			if (g) {
-				activeObjects.emplace_back(g);
+				FrameObject o;
+				o.mesh			= g->GetMesh();
+				o.texture		= g->GetDefaultTexture();
+				o.shader		= g->GetShader();
+				o.colour		= g->GetColour();
+				o.modelMatrix	= g->GetTransform()->GetWorldMatrix();
+				snapshot.objects.emplace_back(o);
 			}
 		}
 	}
 }
 
-void GameTechRenderer::SortObjectList() {
+void GameTechRenderer::SortObjectList(FrameSnapshot& snapshot) {
 
 }
 
@@ -97,15 +190,14 @@ void GameTechRenderer::RenderShadowMap() {
 
 	shadowMatrix = biasMatrix * mvMatrix; //we'll use this one later on
 
-	for (const auto&i : activeObjects) {
-		Matrix4 modelMatrix = (*i).GetTransform()->GetWorldMatrix();
-		Matrix4 mvpMatrix	= mvMatrix * modelMatrix;
+	for (const auto&i : frame->objects) {
+		Matrix4 mvpMatrix	= mvMatrix * i.modelMatrix;
 		glUniformMatrix4fv(mvpLocation, 1, false, (float*)&mvpMatrix);
-		BindMesh((*i).GetMesh());
+		BindMesh(i.mesh);
 		DrawBoundMesh();
 	}
 
-	glViewport(0, 0, currentWidth, currentHeight);
+	glViewport(0, 0, frame->width, frame->height);
 	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
@@ -113,9 +205,8 @@ void GameTechRenderer::RenderShadowMap() {
 }
 
 void GameTechRenderer::RenderCamera() {
-	float screenAspect = (float)currentWidth / (float)currentHeight;
-	Matrix4 viewMatrix = gameWorld.GetMainCamera()->BuildViewMatrix();
-	Matrix4 projMatrix = gameWorld.GetMainCamera()->BuildProjectionMatrix(screenAspect);
+	const Matrix4& viewMatrix = frame->viewMatrix;
+	const Matrix4& projMatrix = frame->projMatrix;
 
 	OGLShader* activeShader = nullptr;
 	int projLocation	= 0;
@@ -134,11 +225,11 @@ void GameTechRenderer::RenderCamera() {
 	glActiveTexture(GL_TEXTURE0 + 1);
 	glBindTexture(GL_TEXTURE_2D, shadowTex);
 
-	for (const auto&i : activeObjects) {
-		OGLShader* shader = (OGLShader*)(*i).GetShader();
+	for (const auto&i : frame->objects) {
+		OGLShader* shader = (OGLShader*)i.shader;
 		BindShader(shader);
 
-		BindTextureToShader((OGLTexture*)(*i).GetDefaultTexture(), "mainTex", 0);
+		BindTextureToShader((OGLTexture*)i.texture, "mainTex", 0);
 
 		if (activeShader != shader) {
 			projLocation	= glGetUniformLocation(shader->GetProgramID(), "projMatrix");
@@ -152,7 +243,7 @@ void GameTechRenderer::RenderCamera() {
 			lightRadiusLocation = glGetUniformLocation(shader->GetProgramID(), "lightRadius");
 
 			cameraLocation = glGetUniformLocation(shader->GetProgramID(), "cameraPos");
-			glUniform3fv(cameraLocation, 1, (float*)&gameWorld.GetMainCamera()->GetPosition());
+			glUniform3fv(cameraLocation, 1, (float*)&frame->cameraPosition);
 
 			glUniformMatrix4fv(projLocation, 1, false, (float*)&projMatrix);
 			glUniformMatrix4fv(viewLocation, 1, false, (float*)&viewMatrix);
@@ -167,25 +258,20 @@ void GameTechRenderer::RenderCamera() {
 			activeShader = shader;
 		}
 
-		Matrix4 modelMatrix = (*i).GetTransform()->GetWorldMatrix();
-		glUniformMatrix4fv(modelLocation, 1, false, (float*)&modelMatrix);			
+		glUniformMatrix4fv(modelLocation, 1, false, (float*)&i.modelMatrix);			
 		
-		Matrix4 fullShadowMat = shadowMatrix * modelMatrix;
+		Matrix4 fullShadowMat = shadowMatrix * i.modelMatrix;
 		glUniformMatrix4fv(shadowLocation, 1, false, (float*)&fullShadowMat);
 
-		glUniform4fv(colourLocation, 1, (float*)&i->GetColour());
+		glUniform4fv(colourLocation, 1, (float*)&i.colour);
 
-		BindMesh((*i).GetMesh());
+		BindMesh(i.mesh);
 		DrawBoundMesh();
 	}
 }
 
 void GameTechRenderer::SetupDebugMatrix(OGLShader*s) {
-	float screenAspect = (float)currentWidth / (float)currentHeight;
-	Matrix4 viewMatrix = gameWorld.GetMainCamera()->BuildViewMatrix();
-	Matrix4 projMatrix = gameWorld.GetMainCamera()->BuildProjectionMatrix(screenAspect);
-
-	Matrix4 vp = projMatrix * viewMatrix;
+	Matrix4 vp = frame->projMatrix * frame->viewMatrix;
 
 	int matLocation = glGetUniformLocation(s->GetProgramID(), "viewProjMatrix");
 
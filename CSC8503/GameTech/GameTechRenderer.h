@@ -6,6 +6,11 @@
 
 #include "../CSC8503Common/GameWorld.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 namespace NCL {
 	class Maths::Vector3;
 	class Maths::Vector4;
@@ -17,21 +22,84 @@ namespace NCL {
 			GameTechRenderer(GameWorld& world);
 			~GameTechRenderer();
 
+			//Call once the frame's simulation is done. Copies everything needed
+			//to draw it out of the world, then draws it - either right away, or
+			//on the render thread while the next frame's being simulated
+			void SubmitFrame();
+
+			//Turns the render thread on or off. While it's on, it owns the GL
+			//context, so nothing else can touch GL - stop it before loading or
+			//deleting meshes, textures and shaders
+			void SetPipelined(bool pipelined);
+
+			bool IsPipelined() const {
+				return renderThread.joinable();
+			}
+
 		protected:
 			void RenderFrame()	override;
+			void EndFrame()		override;
+
+			/*
+			Everything one frame draws, copied out of the world so the
+			simulation can carry on changing it while the frame's drawn. Only
+			the meshes, textures and shaders are shared, and they live as long
+			as the game does.
+			*/
+			struct FrameObject {
+				MeshGeometry*	mesh;
+				TextureBase*	texture;
+				ShaderBase*		shader;
+				Vector4			colour;
+				Matrix4			modelMatrix;
+			};
+
+			struct FrameSnapshot {
+				vector<FrameObject>	objects;
+				vector<DebugString>	debugStrings;
+				vector<DebugLine>	debugLines;
+				FrameArena			debugText;	//the strings' text
+
+				Matrix4		viewMatrix;
+				Matrix4		projMatrix;
+				Vector3		cameraPosition;
+				int			width;
+				int			height;
+			};
 
 			OGLShader*		defaultShader;
 
 			GameWorld&	gameWorld;
 
-			void BuildObjectList();
-			void SortObjectList();
+			void BuildObjectList(FrameSnapshot& snapshot);
+			void SortObjectList(FrameSnapshot& snapshot);
+			void BuildSnapshot(FrameSnapshot& snapshot);
 			void RenderShadowMap();
 			void RenderCamera(); 
 
 			void SetupDebugMatrix(OGLShader*s) override;
 
-			vector<const RenderObject*> activeObjects;
+			void RenderThread();
+
+			/*
+			Triple buffered, so neither side ever waits on the other. The
+			simulation fills writeFrame, then swaps it with latestFrame; the
+			render thread swaps readFrame with latestFrame whenever there's a
+			new one there. If the simulation's quicker, frames the render
+			thread never got round to are just overwritten.
+			*/
+			static const int NewFrame = 4; //set in latestFrame until it's picked up
+
+			FrameSnapshot			frames[3];
+			const FrameSnapshot*	frame;		//the one being drawn
+			int						writeFrame;
+			int						readFrame;
+			std::atomic<int>		latestFrame;
+
+			std::thread				renderThread;
+			std::mutex				frameMutex;		//only so the render thread can sleep until there's a frame
+			std::condition_variable	frameReady;
+			bool					renderThreadAlive;
 
 			//shadow mapping things
 			OGLShader*	shadowShader;
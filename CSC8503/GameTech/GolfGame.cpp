@@ -14,6 +14,9 @@ TutorialGame::TutorialGame()	{
 	world		= new GameWorld();
 	renderer	= new GameTechRenderer(*world);
 	physics		= new PhysicsSystem(*world);
+	navGrid		= new NavigationGrid("Grid.txt");
+	pathCache	= new NavigationPathCache(*navGrid);
+	pathQueue	= new PathRequestQueue(*pathCache);
 
 	forceMagnitude	= 10.0f;
 	useGravity		= false;
@@ -22,6 +25,8 @@ TutorialGame::TutorialGame()	{
 	Debug::SetRenderer(renderer);
 
 	InitialiseAssets();
+
+	renderer->SetPipelined(true); //everything's loaded, so the render thread can have the context now
 }
 
 /*
@@ -50,6 +55,8 @@ void TutorialGame::InitialiseAssets() {
 }
 
 TutorialGame::~TutorialGame()	{
+	renderer->SetPipelined(false); //deleting GL things needs the context back
+
 	delete cubeMesh;
 	delete sphereMesh;
 	delete basicTex;
@@ -57,12 +64,17 @@ TutorialGame::~TutorialGame()	{
 	delete basicTex3;
 	delete basicShader;
 
+	delete pathQueue;
+	delete pathCache;
+	delete navGrid;
+
 	delete physics;
 	delete renderer;
 	delete world;
 }
 
 void TutorialGame::UpdateGame(float dt) {
+	frameArena.Reset();
 
 	DecideState();
 
@@ -82,25 +94,33 @@ void TutorialGame::UpdateGame(float dt) {
 	else {
 		Debug::Print("(G)ravity off", Vector2(10, 40));
 	}
+	if (renderer->IsPipelined()) {
+		Debug::Print("(P)ipelined rendering on", Vector2(10, 60));
+	}
+	else {
+		Debug::Print("(P)ipelined rendering off", Vector2(10, 60));
+	}
 
 	SelectObject();
 	MoveSelectedObject();
 
 	world->UpdateWorld(dt);
 	renderer->Update(dt);
-	physics->Update(dt);
+	UpdatePhysics(dt);
+
+	pathQueue->Update();
 
 	if (currentLevel==1) {
-		testNodes.clear();
 		TestPathfinding();
 		DisplayPathfinding();
 	}
 
 	Debug::FlushRenderables();
-	renderer->Render();
+	renderer->SubmitFrame(); //drawn on the render thread while we simulate the next one
 
-	if (SpinningWall != nullptr)
-		SpinningWall->GetPhysicsObject()->AddTorque(Vector3(0, 10000, 0)); 
+	if (GameObject* wall = GameObject::FromHandle(SpinningWall)) {
+		wall->GetPhysicsObject()->AddTorque(Vector3(0, 10000, 0));
+	}
 
 	if (physics->resetlevel){
 		InitWorld();
@@ -109,6 +129,10 @@ void TutorialGame::UpdateGame(float dt) {
 	
 }
 
+void TutorialGame::UpdatePhysics(float dt) {
+	physics->Update(dt);
+}
+
 void TutorialGame::UpdateKeys() {
 	if (Window::GetKeyboard()->KeyPressed(KEYBOARD_R)) {
 		InitWorld(); //We can reset the simulation at any time with R
@@ -123,6 +147,9 @@ void TutorialGame::UpdateKeys() {
 		useGravity = !useGravity; //Toggle gravity!
 		physics->UseGravity(useGravity);
 	}
+	if (Window::GetKeyboard()->KeyPressed(KEYBOARD_P)) {
+		renderer->SetPipelined(!renderer->IsPipelined()); //to compare frame times with and without the render thread
+	}
 	//Running certain physics updates in a consistent order might cause some
 	//bias in the calculations - the same objects might keep 'winning' the constraint
 	//allowing the other one to stretch too much etc. Shuffling the order so that it
@@ -209,8 +236,9 @@ void TutorialGame::level1() {
 	CurrentSphere = AddSphereToWorld(Vector3(-650, -60, 650), 15.0f);   //Vector3(-650, -60, 650)
 	CurrentSphere->SetName("ball");
 
-	Goal=AddCubeToWorld(Vector3(730, -85, -710), Vector3(20, 10, 20), 0.0f);
-	Goal->SetName("goal");
+	GameObject* goal = AddCubeToWorld(Vector3(730, -85, -710), Vector3(20, 10, 20), 0.0f);
+	goal->SetName("goal");
+	Goal = goal->GetHandle();
 
 	AddCubeToWorld(Vector3(720, -50, -710), Vector3(2, 30, 2), 0.0f);
 	AddCubeToWorld(Vector3(710, -30, -710), Vector3(8, 5, 2), 0.0f); // flag
@@ -228,16 +256,18 @@ void TutorialGame::level1() {
 	AddWallToWorld(Vector3(100, -50, 440), Vector3(300, 40, 10));
 	AddWallToWorld(Vector3(500, -50, -500), Vector3(300, 40, 10));
 
-	Robot = AddCubeToWorld(Vector3(650, -50, 650), Vector3(15, 15, 15), 1.0f);
-	Robot->SetName("robot");
+	GameObject* robot = AddCubeToWorld(Vector3(650, -50, 650), Vector3(15, 15, 15), 1.0f);
+	robot->SetName("robot");
+	Robot = robot->GetHandle();
 }
 
 void TutorialGame::level2() {
 	CurrentSphere=AddSphereToWorld(Vector3(-650, -60, 650), 5.0f);  //(-650, -60, 650), 5.0f);
 	CurrentSphere->SetName("ball");
 
-	Goal = AddCubeToWorld(Vector3(730, -85, -710), Vector3(20, 10, 20), 0.0f);
-	Goal->SetName("goal");
+	GameObject* goal = AddCubeToWorld(Vector3(730, -85, -710), Vector3(20, 10, 20), 0.0f);
+	goal->SetName("goal");
+	Goal = goal->GetHandle();
 
 	AddCubeToWorld(Vector3(720, -50, -710), Vector3(2, 30, 2), 0.0f);
 	AddCubeToWorld(Vector3(710, -30, -710), Vector3(8, 5, 2), 0.0f); // flag
@@ -267,8 +297,9 @@ void TutorialGame::level2() {
 
 	AddWallToWorld(Vector3(-450, -50, -225), Vector3(10, 40, 115));
 
-	SpinningWall = AddSpinToWorld(Vector3(10, -50, -450), Vector3(2, 35, 80), 0.1f); //spinning wall
-	SpinningWall->SetName("spinningWall");
+	GameObject* wall = AddSpinToWorld(Vector3(10, -50, -450), Vector3(2, 35, 80), 0.1f); //spinning wall
+	wall->SetName("spinningWall");
+	SpinningWall = wall->GetHandle();
 }
 
 enum ChangeLevel {stage1, stage2};
@@ -298,33 +329,45 @@ void TutorialGame::DecideState() {
 }
 
 void TutorialGame::TestPathfinding() {
-	NavigationGrid grid("Grid.txt");
-
+	GameObject* robot = GameObject::FromHandle(Robot);
+	if (!robot) {
+		return;
+	}
 	NavigationPath outPath;
 
 	int scale = 260;
 	Vector3 offset = Vector3(scale * 3.5, 0, scale * 3.5);
-	
-	Vector3 startPos = Robot->GetTransform().GetWorldPosition() +offset;
-	Vector3 endPos = CurrentSphere->GetTransform().GetWorldPosition() +offset;
 
-	bool found = grid.FindPath(startPos, endPos, outPath);
+	//Paths are searched for off the game thread, so we keep following the
+	//last one we got until the next one turns up
+	PathRequestStatus status = pathQueue->CollectPath(robotPathTicket, outPath);
 
-	Vector3 pos;
-	while (outPath.PopWaypoint(pos)) {
-		testNodes.push_back(pos - offset);
+	if (status != PathRequestStatus::Pending) {
+		if (status == PathRequestStatus::Found) {
+			testNodes.clear();
+			Vector3 pos;
+			while (outPath.PopWaypoint(pos)) {
+				testNodes.push_back(pos - offset);
+			}
+		}
+		else if (status == PathRequestStatus::NoPath) {
+			testNodes.clear();
+		}
+		Vector3 startPos = robot->GetTransform().GetWorldPosition() + offset;
+		Vector3 endPos = CurrentSphere->GetTransform().GetWorldPosition() + offset;
+
+		robotPathTicket = pathQueue->RequestPath(startPos, endPos);
 	}
 
-	if (found && testNodes.size()>1) {
-		Vector3 a = testNodes[0];
-		Vector3 b = Robot->GetTransform().GetWorldPosition();
+	if (testNodes.size()>1) {
+		Vector3 b = robot->GetTransform().GetWorldPosition();
 		Vector3 d = testNodes[1];
 
 		Vector3 c = d - b;
 
 		c.Normalise();
 
-		Robot->GetPhysicsObject()->AddForce(c*1000);
+		robot->GetPhysicsObject()->AddForce(c*1000);
 	}
 }
 
@@ -342,8 +385,7 @@ void TutorialGame::InitWorld() {
 	world->ClearAndErase();
 	physics->Clear();
 	selectionObject = nullptr;
-	SpinningWall = nullptr;
-	Robot = nullptr;
+	testNodes.clear();
 
 	
 	
@@ -707,10 +749,14 @@ line - after the third, they'll be able to twist under torque aswell.
 */
 
 void TutorialGame::MoveSelectedObject() {
-	renderer->DrawString("Click Force:" + std::to_string(forceMagnitude), Vector2(10, 20)); //Draw debug text at 10,20
+	FrameString forceText("Click Force:", &frameArena);
+	forceText += std::to_string(forceMagnitude).c_str();
+	renderer->DrawString(forceText.c_str(), Vector2(10, 20)); //Draw debug text at 10,20
 	forceMagnitude += Window::GetMouse()->GetWheelMovement() * 1000.0f;  //100.0f
 
-	renderer->DrawString("Score: " + std::to_string(score), Vector2(10, 650));
+	FrameString scoreText("Score: ", &frameArena);
+	scoreText += std::to_string(score).c_str();
+	renderer->DrawString(scoreText.c_str(), Vector2(10, 650));
 
 	if (!selectionObject) {
 		return;//we haven't selected anything!
@@ -722,9 +768,13 @@ void TutorialGame::MoveSelectedObject() {
 		RayCollision closestCollision;
 		if (world->Raycast(ray, closestCollision, true)) {
 			if (closestCollision.node == selectionObject) {
-				selectionObject->GetPhysicsObject()->AddForceAtPosition(ray.GetDirection() * forceMagnitude, closestCollision.collidedAt);
+				TakeShot(selectionObject, ray.GetDirection() * forceMagnitude, closestCollision.collidedAt);
 				++score;
 			}
 		}
 	}
+}
+
+void TutorialGame::TakeShot(GameObject* ball, const Vector3& force, const Vector3& position) {
+	ball->GetPhysicsObject()->AddForceAtPosition(force, position);
 }
\ No newline at end of file
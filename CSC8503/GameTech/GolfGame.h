@@ -2,6 +2,9 @@
 #include "GameTechRenderer.h"
 #include "../CSC8503Common/PhysicsSystem.h"
 #include "../CSC8503Common/NavigationGrid.h"
+#include "../CSC8503Common/NavigationPathCache.h"
+#include "../CSC8503Common/PathRequestQueue.h"
+#include "../../Common/FrameArena.h"
 
 
 namespace NCL {
@@ -9,7 +12,7 @@ namespace NCL {
 		class TutorialGame		{
 		public:
 			TutorialGame();
-			~TutorialGame();
+			virtual ~TutorialGame();
 
 			virtual void UpdateGame(float dt);
 
@@ -25,7 +28,12 @@ namespace NCL {
 			void InitCamera();
 			void UpdateKeys();
 
-			void InitWorld();
+			virtual void InitWorld();
+
+			//Steps the physics - the networked game runs it at a fixed tick instead
+			virtual void UpdatePhysics(float dt);
+			//Pushes a ball with the mouse - force and position are in world space
+			virtual void TakeShot(GameObject* ball, const Vector3& force, const Vector3& position);
 
 			/*
 			These are some of the world/object creation functions I created when testing the functionality
@@ -65,6 +73,13 @@ namespace NCL {
 			PhysicsSystem*		physics;
 			GameWorld*			world;
 
+			FrameArena			frameArena;	//for this frame's temporaries, emptied at the start of the next
+
+			NavigationGrid*		navGrid;
+			NavigationPathCache*	pathCache;
+			PathRequestQueue*	pathQueue;
+			PathTicket			robotPathTicket = -1;
+
 			bool useGravity;
 			bool inSelectionMode;
 
@@ -79,11 +94,14 @@ namespace NCL {
 			OGLTexture* basicTex3 = nullptr;
 			OGLShader*	basicShader = nullptr;
 
-			GameObject* SpinningWall = nullptr;
+			//Handles rather than pointers, so they go stale by themselves when
+			//the level's reset. The ball can be a NetworkPlayer, which isn't
+			//pooled, so it has to stay a pointer
+			GameObject::Handle SpinningWall;
 			GameObject* CurrentSphere = nullptr;
 
-			GameObject* Goal = nullptr;
-			GameObject* Robot = nullptr;
+			GameObject::Handle Goal;
+			GameObject::Handle Robot;
 
 
 			int currentLevel = 1;
@@ -81,8 +81,8 @@ void TestNetworking() {
 	bool canConnect = client->Connect(127, 0, 0, 1, port);
 
 	for (int i = 0; i < 100; ++i) {
-		server->SendGlobalPacket(StringPacket("Server says hello! " + std::to_string(i)));
-		client->SendPacket(StringPacket("Client says helo!" + std::to_string(i)));
+		server->SendGlobalPacket(StringPacketBuffer("Server says hello! " + std::to_string(i)));
+		client->SendPacket(StringPacketBuffer("Client says helo!" + std::to_string(i)));
 
 		server->UpdateServer();
 		client->UpdateClient();
@@ -109,7 +109,17 @@ hide or show the
 
 */
 
-int main() {
+/*
+Pass -networked on the command line for the multiplayer game instead, then
+F5 to host, or F6 to join.
+*/
+int main(int argc, char** argv) {
+	bool networked = false;
+	for (int i = 1; i < argc; ++i) {
+		if (std::string(argv[i]) == "-networked") {
+			networked = true;
+		}
+	}
 	Window*w = Window::CreateGameWindow("Golf Game", 1980, 1080, false);
 
 	if (!w->HasInitialised()) {
@@ -123,7 +133,7 @@ int main() {
 	w->ShowOSPointer(false);
 	w->LockMouseToWindow(true);
 
-	TutorialGame* g = new TutorialGame();
+	TutorialGame* g = networked ? new NetworkedGame() : new TutorialGame();
 
 	while (w->UpdateWindow() && !Window::GetKeyboard()->KeyDown(KEYBOARD_ESCAPE)) {
 		float dt = w->GetTimer()->GetTimeDelta() / 1000.0f;
@@ -144,5 +154,6 @@ int main() {
 
 		g->UpdateGame(dt);
 	}
+	delete g; //stops the render thread before the window goes
 	Window::DestroyGameWindow();
 }
\ No newline at end of file
@@ -2,5 +2,620 @@
 #include "NetworkPlayer.h"
 #include "../CSC8503Common/GameServer.h"
 #include "../CSC8503Common/GameClient.h"
+#include "../CSC8503Common/Debug.h"
+#include "../../Common/Window.h"
+#include <iostream>
 
-#define COLLISION_MSG 30
\ No newline at end of file
+#define COLLISION_MSG 30
+
+using namespace NCL;
+using namespace CSC8503;
+
+const float NETWORK_TICK			= 1.0f / 60.0f;
+const int	MAX_TICKS_PER_FRAME		= 5;	//after a long frame, give up catching up rather than spiralling
+
+const int	SNAPSHOT_TICKS			= 3;	//20 snapshots a second
+const int	FULL_SNAPSHOT_INTERVAL	= 10;	//every 10th snapshot is a full one
+const float SNAPSHOT_TIME			= SNAPSHOT_TICKS * NETWORK_TICK;
+
+const float INTERPOLATION_DELAY		= 2.0f * SNAPSHOT_TIME;
+const float MAX_EXTRAPOLATION		= SNAPSHOT_TIME * 2.0f;	//objects stop rather than wander off if snapshots dry up
+const float CLOCK_RESYNC			= 0.5f;	//seconds out before we give up easing the server clock back
+const float CLOCK_CORRECTION		= 0.1f;	//how much of the error each snapshot takes away
+
+const int	INPUT_HISTORY_SIZE		= 128;	//a couple of seconds of ticks to replay from
+const int	MAX_BUFFERED_INPUTS		= 8;	//server drops the oldest beyond this, rather than falling behind
+const float RECONCILE_TOLERANCE		= 1.0f;	//world units the server can disagree by before we rewind
+
+//Range coder gets snapshots down to about a third, Snapshot to about a half but
+//several times quicker (measured when compression went in). Clients have to match the server
+const NetworkCompression COMPRESSION	= NetworkCompression::RangeCoder;
+
+const float RELEVANCY_RADIUS		= 800.0f;	//about half the course, around each player's ball
+const int	SNAPSHOT_BUDGET			= 1000;		//bytes per client per snapshot, so each fits in one packet
+
+const int	PLAYER_NETWORK_ID_BASE	= 1000;	//level objects are numbered from 0
+const float PLAYER_RADIUS			= 10.0f;
+const float PLAYER_INVERSE_MASS		= 10.0f;
+const Vector3 PLAYER_SPAWN			= Vector3(-650, -60, 650);
+
+NetworkedGame::NetworkedGame()	{
+	thisServer = nullptr;
+	thisClient = nullptr;
+
+	tickTime	= 0.0f;
+	serverTick	= 0;
+
+	localPlayerID	= -1;
+	localPlayer		= nullptr;
+	serverLevel		= currentLevel;
+	startingLevel	= false;
+
+	inputID				= -1;
+	lastStateInput		= -1;
+	hasPendingShot		= false;
+	lastShotID			= -1;
+
+	inputHistory.resize(INPUT_HISTORY_SIZE);
+
+	latestSnapshot		= -1;
+	snapshotTime		= 0.0f;
+	serverTime			= 0.0f;
+	interpolationDelay	= INTERPOLATION_DELAY;
+
+	showNetworkStats	= false;
+}
+
+NetworkedGame::~NetworkedGame()	{
+	bool started = thisServer || thisClient;
+
+	delete thisServer;
+	delete thisClient;
+
+	if (started) {
+		NetworkBase::Destroy();
+	}
+}
+
+void NetworkedGame::StartAsServer() {
+	NetworkBase::Initialise();
+
+	thisServer = new GameServer(NetworkBase::GetDefaultPort(), 4);
+	if (!thisServer->SetCompression(COMPRESSION)) { //no client could understand us, so don't pretend
+		std::cout << "Server: couldn't start with the clients' compression, not hosting" << std::endl;
+		delete thisServer;
+		thisServer = nullptr;
+		NetworkBase::Destroy();
+		return;
+	}
+	thisServer->SetGameWorld(*world);
+	thisServer->SetRelevancy(RELEVANCY_RADIUS, SNAPSHOT_BUDGET); //each player's focus is set as their ball spawns
+
+	thisServer->RegisterPacketHandler(Received_State, this);
+	thisServer->RegisterPacketHandler(Player_Connected, this);
+	thisServer->RegisterPacketHandler(Player_Disconnected, this);
+
+	InitWorld(); //everyone starts from the same place
+}
+
+void NetworkedGame::StartAsClient(char a, char b, char c, char d) {
+	NetworkBase::Initialise();
+
+	thisClient = new GameClient();
+	if (!thisClient->SetCompression(COMPRESSION)) { //the server wouldn't understand us
+		std::cout << "Client: couldn't start with the server's compression, not joining" << std::endl;
+		delete thisClient;
+		thisClient = nullptr;
+		NetworkBase::Destroy();
+		return;
+	}
+	thisClient->Connect(a, b, c, d, NetworkBase::GetDefaultPort());
+
+	thisClient->RegisterPacketHandler(Snapshot_State, this);
+	thisClient->RegisterPacketHandler(Full_State, this);
+	thisClient->RegisterPacketHandler(Delta_State, this);
+	thisClient->RegisterPacketHandler(Player_Connected, this);
+	thisClient->RegisterPacketHandler(Player_Disconnected, this);
+	thisClient->RegisterPacketHandler(Player_State, this);
+	thisClient->RegisterPacketHandler(Level_Start, this);
+}
+
+void NetworkedGame::UpdateGame(float dt) {
+	if (!thisServer && !thisClient) {
+		if (Window::GetKeyboard()->KeyPressed(KEYBOARD_F5)) {
+			StartAsServer();
+		}
+		else if (Window::GetKeyboard()->KeyPressed(KEYBOARD_F6)) {
+			StartAsClient(127, 0, 0, 1);
+		}
+	}
+	if (thisServer) {
+		thisServer->UpdateServer();
+		thisServer->UpdateStats(dt);
+
+		if (Window::GetKeyboard()->KeyPressed(KEYBOARD_F4)) {
+			showNetworkStats = !showNetworkStats;
+		}
+		if (showNetworkStats) {
+			DrawNetworkStats();
+		}
+	}
+	if (thisClient) {
+		thisClient->UpdateClient();
+	}
+	TutorialGame::UpdateGame(dt);
+}
+
+void NetworkedGame::DrawNetworkStats() const {
+	const NetworkServerStats& stats = thisServer->GetStats();
+
+	Vector2 position(800, 650);
+	auto printLine = [&](const std::string& text) {
+		Debug::Print(text, position);
+		position.y -= 20.0f;
+	};
+	printLine("Clients: " + std::to_string(stats.peerCount));
+	printLine("In: " + std::to_string((int)stats.bytesIn) + " B/s, " + std::to_string((int)stats.packetsIn) + " packets/s");
+	printLine("Out: " + std::to_string((int)stats.bytesOut) + " B/s, " + std::to_string((int)stats.packetsOut) + " packets/s");
+	printLine("Snapshots: " + std::to_string((int)stats.snapshotBytes) + " B, largest " + std::to_string(stats.largestSnapshot) + " B");
+	printLine("States/s: " + std::to_string((int)stats.fullStates) + " full, " + std::to_string((int)stats.deltaStates) + " delta");
+	printLine("Late/s: " + std::to_string((int)stats.latePackets) + ", bad/s: " + std::to_string((int)stats.badPackets));
+
+	for (auto& i : players) {
+		NetworkPeerStats peer;
+		if (thisServer->GetPeerStats(i.first, peer)) {
+			printLine("Player " + std::to_string(i.first) + ": " + std::to_string(peer.roundTripTime) + "ms +-" +
+				std::to_string(peer.roundTripJitter) + ", " + std::to_string((int)(peer.packetLoss * 100.0f)) + "% lost, " +
+				std::to_string((int)peer.bytesOut) + " B/s");
+		}
+	}
+}
+
+void NetworkedGame::UpdatePhysics(float dt) {
+	if (!thisServer && !thisClient) {
+		TutorialGame::UpdatePhysics(dt);
+		return;
+	}
+	tickTime += dt;
+
+	int ticks = 0;
+	while (tickTime >= NETWORK_TICK) {
+		tickTime -= NETWORK_TICK;
+		if (++ticks > MAX_TICKS_PER_FRAME) {
+			tickTime = 0.0f;
+			break;
+		}
+		if (thisServer) {
+			ServerTick();
+		}
+		else {
+			ClientTick();
+		}
+	}
+	if (thisClient) {
+		UpdateInterpolation(dt);
+	}
+}
+
+void NetworkedGame::TakeShot(GameObject* ball, const Vector3& force, const Vector3& position) {
+	if (!thisClient) {
+		TutorialGame::TakeShot(ball, force, position);
+		return;
+	}
+	if (!localPlayer || ball != localPlayer) {
+		return; //can only hit our own ball, everything else is up to the server
+	}
+	hasPendingShot		= true;
+	pendingShotForce	= force;
+	pendingShotOffset	= position - localPlayer->GetTransform().GetWorldPosition();
+}
+
+void NetworkedGame::InitWorld() {
+	if (thisClient && !startingLevel) {
+		currentLevel = serverLevel;
+		return;
+	}
+	selectionObject = nullptr;
+	localPlayer		= nullptr;
+
+	TutorialGame::InitWorld(); //deletes all of the old players too
+	RegisterNetworkObjects();
+
+	if (thisServer) {
+		serverLevel = currentLevel;
+		LevelStartPacket level(currentLevel);
+		for (auto& i : players) {
+			thisServer->SendPeerPacket(i.first, level, true);
+		}
+	}
+}
+
+/*
+Both sides build the level in the same order, so the dynamic objects get
+the same IDs on each without anything having to be sent. Players then get
+put back in, with IDs of their own.
+*/
+void NetworkedGame::RegisterNetworkObjects() {
+	networkObjects.clear();
+
+	std::vector<GameObject*>::const_iterator first;
+	std::vector<GameObject*>::const_iterator last;
+	world->GetObjectIterators(first, last);
+
+	int nextID = 0;
+	for (auto i = first; i != last; ++i) {
+		PhysicsObject* physicsObject = (*i)->GetPhysicsObject();
+		if (!physicsObject || physicsObject->GetInverseMass() == 0.0f) {
+			continue; //never moves, so there's nothing to send
+		}
+		NetworkObject* o = new NetworkObject(**i, nextID++);
+		(*i)->SetNetworkObject(o);
+		networkObjects[o->GetNetworkID()] = o;
+
+		if (thisClient) {
+			SetupClientObject(**i, false);
+		}
+	}
+	std::vector<int> playerIDs;
+	for (auto& i : players) {
+		playerIDs.emplace_back(i.first);
+	}
+	players.clear();
+	for (int id : playerIDs) {
+		SpawnPlayer(id);
+	}
+}
+
+void NetworkedGame::SpawnPlayer(int playerID) {
+	if (players.count(playerID)) {
+		return;
+	}
+	NetworkPlayer* ball = new NetworkPlayer(this, playerID);
+
+	SphereVolume* volume = new SphereVolume(PLAYER_RADIUS);
+	ball->SetBoundingVolume((CollisionVolume*)volume);
+	ball->GetTransform().SetWorldScale(Vector3(PLAYER_RADIUS, PLAYER_RADIUS, PLAYER_RADIUS));
+	ball->GetTransform().SetWorldPosition(PLAYER_SPAWN + Vector3((playerID + 1) * PLAYER_RADIUS * 4.0f, 0, 0));
+
+	ball->SetRenderObject(new RenderObject(&ball->GetTransform(), sphereMesh, basicTex3, basicShader));
+	ball->SetPhysicsObject(new PhysicsObject(&ball->GetTransform(), ball->GetBoundingVolume()));
+
+	ball->GetPhysicsObject()->SetInverseMass(PLAYER_INVERSE_MASS);
+	ball->GetPhysicsObject()->InitSphereInertia();
+	ball->SetName("ball");
+
+	NetworkObject* o = new NetworkObject(*ball, PLAYER_NETWORK_ID_BASE + playerID);
+	ball->SetNetworkObject(o);
+	networkObjects[o->GetNetworkID()] = o;
+
+	world->AddGameObject(ball);
+	players[playerID] = ball;
+
+	if (thisServer) {
+		thisServer->SetClientFocus(playerID, ball);
+	}
+	if (thisClient) {
+		if (playerID == localPlayerID) {
+			localPlayer		= ball;
+			CurrentSphere	= ball;
+		}
+		SetupClientObject(*ball, playerID == localPlayerID);
+	}
+}
+
+void NetworkedGame::RemovePlayer(int playerID) {
+	auto i = players.find(playerID);
+	if (i == players.end()) {
+		return;
+	}
+	NetworkPlayer* ball = i->second;
+	players.erase(i);
+
+	networkObjects.erase(PLAYER_NETWORK_ID_BASE + playerID);
+	world->RemoveGameObject(ball);
+	physics->RemoveCollisions(ball);
+
+	if (selectionObject == ball) {
+		selectionObject = nullptr;
+	}
+	if (localPlayer == ball) {
+		localPlayer = nullptr;
+	}
+	delete ball;
+}
+
+void NetworkedGame::ServerPlayerConnected(int playerID) {
+	SpawnPlayer(playerID);
+	playerInputs[playerID] = PlayerInputs();
+
+	//The new player needs the level and everyone in it, everyone else just needs them
+	LevelStartPacket level(currentLevel);
+	thisServer->SendPeerPacket(playerID, level, true);
+
+	for (auto& i : players) {
+		NewPlayerPacket newPlayer(i.first);
+		thisServer->SendPeerPacket(playerID, newPlayer, true);
+
+		if (i.first != playerID) {
+			NewPlayerPacket joined(playerID);
+			thisServer->SendPeerPacket(i.first, joined, true);
+		}
+	}
+}
+
+void NetworkedGame::ServerTick() {
+	for (auto& i : playerInputs) {
+		ApplyServerInput(i.first, i.second);
+	}
+	physics->Update(NETWORK_TICK);
+	serverTick++;
+
+	if (serverTick % SNAPSHOT_TICKS == 0) {
+		int snapshot = serverTick / SNAPSHOT_TICKS;
+		thisServer->BroadcastSnapshot(snapshot % FULL_SNAPSHOT_INTERVAL != 0);
+		SendPlayerStates();
+	}
+}
+
+/*
+One input a tick, so the server's ball sees the same ticks between each
+input as the client's did. A shot is applied the first time an input turns
+up that carries it - if the one it was taken on went missing, the next
+packet has it too.
+*/
+void NetworkedGame::ApplyServerInput(int playerID, PlayerInputs& inputs) {
+	if (inputs.pending.empty()) {
+		return;
+	}
+	ClientPacket input = inputs.pending.front();
+	inputs.pending.pop_front();
+	inputs.lastInputID = input.inputID;
+
+	auto player = players.find(playerID);
+	if (player == players.end() || input.shotID <= inputs.lastShotID) {
+		return;
+	}
+	inputs.lastShotID = input.shotID;
+
+	GameObject* ball = player->second;
+	ball->GetPhysicsObject()->AddForceAtPosition(input.shotForce, ball->GetTransform().GetWorldPosition() + input.shotOffset);
+}
+
+void NetworkedGame::SendPlayerStates() {
+	for (auto& i : players) {
+		GameObject*		ball		= i.second;
+		PhysicsObject*	ballPhysics	= ball->GetPhysicsObject();
+
+		PlayerStatePacket state;
+		state.playerID			= i.first;
+		state.inputID			= playerInputs[i.first].lastInputID;
+		state.position			= ball->GetTransform().GetWorldPosition();
+		state.orientation		= ball->GetTransform().GetLocalOrientation();
+		state.linearVelocity	= ballPhysics->GetLinearVelocity();
+		state.angularVelocity	= ballPhysics->GetAngularVelocity();
+
+		thisServer->SendPeerPacket(i.first, state);
+	}
+}
+
+void NetworkedGame::ClientTick() {
+	inputID++;
+
+	PredictedInput& input = inputHistory[inputID % INPUT_HISTORY_SIZE];
+	input.inputID	= inputID;
+	input.hasShot	= false;
+
+	if (hasPendingShot && localPlayer) {
+		input.hasShot		= true;
+		input.shotForce		= pendingShotForce;
+		input.shotOffset	= pendingShotOffset;
+
+		lastShotID		= inputID;
+		lastShotForce	= pendingShotForce;
+		lastShotOffset	= pendingShotOffset;
+
+		localPlayer->GetPhysicsObject()->AddForceAtPosition(input.shotForce, localPlayer->GetTransform().GetWorldPosition() + input.shotOffset);
+	}
+	hasPendingShot = false;
+
+	physics->Update(NETWORK_TICK);
+	physics->reachedGoal	= false; //the server decides these
+	physics->resetlevel		= false;
+
+	StorePrediction(input);
+
+	ClientPacket packet;
+	packet.lastID		= thisClient->GetLastFullSnapshot();
+	packet.inputID		= inputID;
+	packet.shotID		= lastShotID;
+	packet.shotForce	= lastShotForce;
+	packet.shotOffset	= lastShotOffset;
+	thisClient->SendPacket(packet);
+}
+
+void NetworkedGame::StorePrediction(PredictedInput& input) {
+	if (!localPlayer) {
+		return;
+	}
+	input.position			= localPlayer->GetTransform().GetWorldPosition();
+	input.orientation		= localPlayer->GetTransform().GetLocalOrientation();
+	input.linearVelocity	= localPlayer->GetPhysicsObject()->GetLinearVelocity();
+	input.angularVelocity	= localPlayer->GetPhysicsObject()->GetAngularVelocity();
+}
+
+void NetworkedGame::ReconcilePlayer(const PlayerStatePacket& state) {
+	if (state.playerID != localPlayerID) {
+		if (localPlayer) {
+			SetupClientObject(*localPlayer, false);
+		}
+		localPlayerID	= state.playerID; //first we've heard of which one we are
+		lastStateInput	= -1;
+		localPlayer		= nullptr;
+
+		auto i = players.find(localPlayerID);
+		if (i != players.end()) {
+			localPlayer		= i->second;
+			CurrentSphere	= localPlayer;
+			SetupClientObject(*localPlayer, true);
+		}
+	}
+	if (!localPlayer || (state.inputID >= 0 && state.inputID <= lastStateInput)) {
+		return; //arrived out of order, we've already used a newer one
+	}
+	lastStateInput = state.inputID;
+
+	bool canReplay = state.inputID >= 0 && inputID - state.inputID < INPUT_HISTORY_SIZE;
+	if (canReplay) {
+		const PredictedInput& predicted = inputHistory[state.inputID % INPUT_HISTORY_SIZE];
+		if (predicted.inputID == state.inputID && (predicted.position - state.position).Length() < RECONCILE_TOLERANCE) {
+			return; //close enough, keep going with what we've got
+		}
+	}
+	Transform&		transform	= localPlayer->GetTransform();
+	PhysicsObject*	ballPhysics	= localPlayer->GetPhysicsObject();
+
+	transform.SetWorldPosition(state.position);
+	transform.SetLocalOrientation(state.orientation);
+	ballPhysics->SetLinearVelocity(state.linearVelocity);
+	ballPhysics->SetAngularVelocity(state.angularVelocity);
+
+	if (!canReplay) {
+		return;
+	}
+	for (int i = state.inputID + 1; i <= inputID; ++i) {
+		PredictedInput& input = inputHistory[i % INPUT_HISTORY_SIZE];
+		if (input.hasShot) {
+			ballPhysics->AddForceAtPosition(input.shotForce, transform.GetWorldPosition() + input.shotOffset);
+		}
+		physics->PredictObject(*localPlayer, NETWORK_TICK);
+		StorePrediction(input);
+	}
+}
+
+/*
+Our own ball is simulated here, and everything else just goes where the
+server says - as far as our physics is concerned, those are immovable.
+*/
+void NetworkedGame::SetupClientObject(GameObject& o, bool isLocalPlayer) {
+	NetworkObject* networkObject = o.GetNetworkObject();
+	PhysicsObject* physicsObject = o.GetPhysicsObject();
+
+	networkObject->SetPredicted(isLocalPlayer);
+	networkObject->SetInterpolated(!isLocalPlayer);
+
+	physicsObject->SetInverseMass(isLocalPlayer ? PLAYER_INVERSE_MASS : 0.0f);
+	physicsObject->InitSphereInertia(); //only players are ever given mass back, and they're spheres
+	physicsObject->SetLinearVelocity(Vector3(0, 0, 0));
+	physicsObject->SetAngularVelocity(Vector3(0, 0, 0));
+}
+
+/*
+Snapshots are sent at a fixed rate, so their IDs tell us the server time
+they were sent at. Our own copy of that clock ticks along with the frame
+time, and each new snapshot nudges it back in line, so a single late or
+early one can't make everything lurch.
+*/
+void NetworkedGame::UpdateServerClock(int snapshotID) {
+	snapshotTime = snapshotID * SNAPSHOT_TIME;
+
+	if (snapshotID <= latestSnapshot) {
+		return;
+	}
+	bool firstSnapshot	= latestSnapshot < 0;
+	latestSnapshot		= snapshotID;
+
+	float error = snapshotTime - serverTime;
+	if (firstSnapshot || fabs(error) > CLOCK_RESYNC) {
+		serverTime = snapshotTime;
+	}
+	else {
+		serverTime += error * CLOCK_CORRECTION;
+	}
+}
+
+void NetworkedGame::UpdateInterpolation(float dt) {
+	serverTime += dt;
+	float renderTime = serverTime - interpolationDelay;
+
+	for (auto& i : networkObjects) {
+		i.second->UpdateInterpolation(renderTime, MAX_EXTRAPOLATION);
+	}
+}
+
+void NetworkedGame::ReceivePacket(int type, GamePacket* payload, int source) {
+	if ((type == Player_Connected || type == Player_Disconnected) && payload->GetTotalSize() < (int)sizeof(NewPlayerPacket)) {
+		return;
+	}
+	if (thisServer) {
+		if (type == Player_Connected) {
+			ServerPlayerConnected(((NewPlayerPacket*)payload)->playerID);
+		}
+		else if (type == Player_Disconnected) {
+			int playerID = ((PlayerDisconnectPacket*)payload)->playerID;
+			RemovePlayer(playerID);
+			playerInputs.erase(playerID);
+
+			PlayerDisconnectPacket left(playerID);
+			for (auto& i : players) {
+				thisServer->SendPeerPacket(i.first, left, true);
+			}
+		}
+		else if (type == Received_State && payload->GetTotalSize() >= (int)sizeof(ClientPacket)) {
+			auto i = playerInputs.find(source);
+			if (i == playerInputs.end()) {
+				return;
+			}
+			ClientPacket*	input	= (ClientPacket*)payload;
+			PlayerInputs&	inputs	= i->second;
+
+			int newest = inputs.pending.empty() ? inputs.lastInputID : inputs.pending.back().inputID;
+			if (input->inputID <= newest) {
+				return; //late, we've already moved on from it
+			}
+			inputs.pending.emplace_back(*input);
+			while ((int)inputs.pending.size() > MAX_BUFFERED_INPUTS) {
+				ApplyServerInput(source, inputs); //falling behind, so catch up
+			}
+		}
+		return;
+	}
+	switch (type) {
+		case Snapshot_State: {
+			SnapshotPacket* snapshot = (SnapshotPacket*)payload;
+			UpdateServerClock(snapshot->snapshotID);
+		}break;
+		case Full_State:
+		case Delta_State: {
+			if (payload->GetTotalSize() < (int)(sizeof(GamePacket) + sizeof(int) * 2)) {
+				return;
+			}
+			int objectID = type == Full_State ? ((FullPacket*)payload)->objectID : ((DeltaPacket*)payload)->objectID;
+			auto i = networkObjects.find(objectID);
+			if (i != networkObjects.end()) {
+				i->second->SetPacketTime(snapshotTime);
+				i->second->ReadPacket(*payload);
+			}
+		}break;
+		case Player_Connected: {
+			SpawnPlayer(((NewPlayerPacket*)payload)->playerID);
+		}break;
+		case Player_Disconnected: {
+			RemovePlayer(((PlayerDisconnectPacket*)payload)->playerID);
+		}break;
+		case Player_State: {
+			if (payload->GetTotalSize() >= (int)sizeof(PlayerStatePacket)) {
+				ReconcilePlayer(*(PlayerStatePacket*)payload);
+			}
+		}break;
+		case Level_Start: {
+			if (payload->GetTotalSize() < (int)sizeof(LevelStartPacket)) {
+				return;
+			}
+			serverLevel		= ((LevelStartPacket*)payload)->level;
+			currentLevel	= serverLevel;
+			startingLevel	= true;
+			InitWorld();
+			startingLevel	= false;
+		}break;
+	}
+}
\ No newline at end of file
@@ -1,2 +1,183 @@
 #pragma once
-#include "GolfGame.h"
\ No newline at end of file
+#include "GolfGame.h"
+#include "../CSC8503Common/NetworkBase.h"
+#include "../CSC8503Common/NetworkObject.h"
+
+#include <deque>
+#include <map>
+#include <vector>
+
+namespace NCL {
+	namespace CSC8503 {
+		class GameServer;
+		class GameClient;
+		class NetworkPlayer;
+
+		enum NetworkedGameMessages {
+			Player_State = BasicNetworkMessages::Snapshot_State + 1,
+			Level_Start
+		};
+
+		/*
+		Sent to each client along with every snapshot - the server's state for
+		their own ball, and the newest of their inputs that had been applied
+		to it. The velocities are in there so the client can replay from it.
+		*/
+		struct PlayerStatePacket : public GamePacket {
+			int			playerID;
+			int			inputID;	//-1 if none of their inputs have been applied yet
+			Vector3		position;
+			Quaternion	orientation;
+			Vector3		linearVelocity;
+			Vector3		angularVelocity;
+
+			PlayerStatePacket() {
+				type		= NetworkedGameMessages::Player_State;
+				size		= sizeof(PlayerStatePacket) - sizeof(GamePacket);
+				playerID	= -1;
+				inputID		= -1;
+			}
+		};
+
+		struct LevelStartPacket : public GamePacket {
+			int level;
+
+			LevelStartPacket(int l) {
+				type	= NetworkedGameMessages::Level_Start;
+				size	= sizeof(int);
+				level	= l;
+			}
+		};
+
+		/*
+		The server runs the real game, and everyone that connects gets a ball of
+		their own to hit. Clients don't wait to hear what their shots did - they
+		run the physics for their own ball straight away, and remember every
+		tick's input along with where it left the ball. When the server's state
+		for one of those ticks comes back and disagrees by too much, the ball is
+		put back where the server had it, and the inputs the server hadn't seen
+		yet are replayed on top of that with PhysicsSystem::PredictObject.
+
+		Both sides run the physics at a fixed tick, so a replayed tick covers
+		exactly the same time as it did the first time around. Shots feel
+		instant however long the round trip is, without the server having to
+		send state any more often. F5 starts a server, F6 joins one on this PC.
+
+		Everything else on a client is only moved by the server. Rather than
+		jumping to each snapshot as it arrives, those objects are drawn a
+		little in the past (see SetInterpolationDelay), between the two
+		snapshots either side of then, so snapshots can be sent a lot less
+		often than the game ticks without anything looking jerky.
+		*/
+		class NetworkedGame : public TutorialGame, public PacketReceiver {
+		public:
+			NetworkedGame();
+			~NetworkedGame();
+
+			void StartAsServer();
+			void StartAsClient(char a, char b, char c, char d);
+
+			void UpdateGame(float dt) override;
+
+			void ReceivePacket(int type, GamePacket* payload, int source) override;
+
+			//How far behind the server clients draw everything they don't control.
+			//Needs to be more than the time between snapshots, plus some jitter
+			void SetInterpolationDelay(float seconds) {
+				interpolationDelay = seconds;
+			}
+
+		protected:
+			//Server side, for each connected player
+			struct PlayerInputs {
+				std::deque<ClientPacket>	pending;	//applied one per tick, oldest first
+				int							lastInputID;
+				int							lastShotID;
+
+				PlayerInputs() {
+					lastInputID = -1;
+					lastShotID	= -1;
+				}
+			};
+
+			//Client side, for each tick
+			struct PredictedInput {
+				int			inputID;
+				bool		hasShot;
+				Vector3		shotForce;
+				Vector3		shotOffset;
+
+				//where the local ball was at the end of the tick
+				Vector3		position;
+				Quaternion	orientation;
+				Vector3		linearVelocity;
+				Vector3		angularVelocity;
+
+				PredictedInput() {
+					inputID = -1;
+					hasShot = false;
+				}
+			};
+
+			void InitWorld() override;
+			void UpdatePhysics(float dt) override;
+			void TakeShot(GameObject* ball, const Vector3& force, const Vector3& position) override;
+
+			void ServerTick();
+			void ClientTick();
+
+			void RegisterNetworkObjects();
+			void SpawnPlayer(int playerID);
+			void RemovePlayer(int playerID);
+
+			void ServerPlayerConnected(int playerID);
+			void ApplyServerInput(int playerID, PlayerInputs& inputs);
+			void SendPlayerStates();
+
+			void StorePrediction(PredictedInput& input);
+			void ReconcilePlayer(const PlayerStatePacket& state);
+
+			void SetupClientObject(GameObject& o, bool isLocalPlayer);
+			void UpdateServerClock(int snapshotID);
+			void UpdateInterpolation(float dt);
+
+			void DrawNetworkStats() const;
+
+			GameServer* thisServer;
+			GameClient* thisClient;
+
+			float	tickTime;	//not yet simulated
+			int		serverTick;
+
+			std::map<int, NetworkObject*>	networkObjects;	//by network ID
+			std::map<int, NetworkPlayer*>	players;		//by player ID, which is their peer ID on the server
+
+			std::map<int, PlayerInputs>		playerInputs;
+
+			int				localPlayerID;
+			NetworkPlayer*	localPlayer;
+			int				serverLevel;
+			bool			startingLevel;	//clients only change level when the server says so
+
+			int		inputID;
+			int		lastStateInput;	//newest inputID the server has told us about
+
+			bool	hasPendingShot;	//taken this frame, applied on the next tick
+			Vector3 pendingShotForce;
+			Vector3 pendingShotOffset;
+
+			int		lastShotID;	//repeated in every ClientPacket
+			Vector3 lastShotForce;
+			Vector3 lastShotOffset;
+
+			std::vector<PredictedInput> inputHistory;	//ring buffer, indexed by inputID % size
+
+			int		latestSnapshot;
+			float	snapshotTime;		//server time of the snapshot being read
+			float	serverTime;			//our best guess at it, kept ticking between snapshots
+			float	interpolationDelay;
+
+			bool	showNetworkStats;	//server only, toggled with F4
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "../CSC8503Common/GameWorld.h"
+#include "../CSC8503Common/GameObject.h"
+#include "../CSC8503Common/Transform.h"
+
+#include "../../Common/JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <random>
+
+using namespace NCL;
+using namespace CSC8503;
+
+/*
+Randomly moves, scales, spins and reparents the transforms of a world full
+of little hierarchies, some added before their parents and some with
+parents that aren't in the world at all, and checks that what UpdateWorld
+leaves in each world matrix (only rebuilding what's dirty) is the same as
+working every one out again from scratch. Change the seed to get a
+different (but still repeatable) set of changes.
+
+With jobs, every level of the hierarchy is updated on its workers, however
+small - build with -fsanitize=thread to check for races.
+*/
+bool TestTransformHierarchy(JobSystem* jobs = nullptr) {
+	const int objectCount	= 2000;
+	const int frames		= 200;
+	const int changes		= 50; //per frame
+
+	std::mt19937 random(1234);
+	auto randomFloat = [&random](float range) {
+		return std::uniform_real_distribution<float>(-range, range)(random);
+	};
+
+	vector<GameObject*> objects;
+	for (int i = 0; i < objectCount; ++i) {
+		objects.emplace_back(new GameObject());
+	}
+	for (int i = 0; i < objectCount; ++i) {
+		if (i % 3 != 0) { //the one before is often a child too, so we get chains
+			objects[i]->GetTransform().SetParent(&objects[i - 1]->GetTransform());
+		}
+	}
+	GameWorld world;
+	if (jobs) {
+		world.SetJobSystem(jobs);
+		world.SetParallelTransformThreshold(0);
+	}
+	vector<GameObject*> addOrder = objects;
+	std::shuffle(addOrder.begin(), addOrder.end(), random); //so plenty of children go in before their parents
+	vector<GameObject*> outside;
+	for (GameObject* o : addOrder) {
+		if (outside.size() < objectCount / 10) {
+			outside.emplace_back(o); //only reached through their children
+		}
+		else {
+			world.AddGameObject(o);
+		}
+	}
+
+	std::function<Matrix4(const Transform&)> fullWorldMatrix = [&fullWorldMatrix](const Transform& t) {
+		Matrix4 local = Matrix4::TRS(t.GetLocalPosition(), t.GetLocalOrientation(), t.GetLocalScale());
+		return t.GetParent() ? fullWorldMatrix(*t.GetParent()) * local : local;
+	};
+	auto isAncestor = [](const Transform* ancestor, const Transform* t) {
+		for (const Transform* p = t; p; p = p->GetParent()) {
+			if (p == ancestor) {
+				return true;
+			}
+		}
+		return false;
+	};
+
+	float	largestDifference	= 0.0f;
+	int		badCopies			= 0;
+	for (int f = 0; f < frames; ++f) {
+		for (int c = 0; c < changes; ++c) {
+			Transform& t = objects[random() % objectCount]->GetTransform();
+			switch (random() % 5) {
+				case 0: t.SetLocalPosition(Vector3(randomFloat(10), randomFloat(10), randomFloat(10))); break;
+				case 1: t.SetLocalScale(Vector3(1.0f + randomFloat(0.5f), 1.0f + randomFloat(0.5f), 1.0f + randomFloat(0.5f))); break;
+				case 2: t.SetLocalOrientation(Quaternion::EulerAnglesToQuaternion(randomFloat(180), randomFloat(180), randomFloat(180))); break;
+				case 3: {
+					Transform* newParent = (random() % 4 == 0) ? nullptr : &objects[random() % objectCount]->GetTransform();
+					if (!newParent || !isAncestor(&t, newParent)) { //no loops
+						t.SetParent(newParent);
+					}
+				}break;
+				case 4: {
+					Transform copy(t);
+					copy.UpdateMatrices();
+					Matrix4 expected = Matrix4::TRS(t.GetLocalPosition(), t.GetLocalOrientation(), t.GetLocalScale());
+					bool sameMatrix = memcmp(copy.GetWorldMatrix().values, expected.values, sizeof(expected.values)) == 0;
+					if (copy.GetParent() || !copy.GetChildren().empty() || !sameMatrix) {
+						badCopies++;
+					}
+				}break;
+			}
+		}
+		world.UpdateWorld(0.0f);
+
+		for (GameObject* o : objects) {
+			if (std::find(outside.begin(), outside.end(), o) != outside.end()) {
+				continue; //nothing updates these unless they've got children in the world
+			}
+			Matrix4 expected	= fullWorldMatrix(o->GetTransform());
+			Matrix4 actual		= o->GetTransform().GetWorldMatrix();
+			for (int i = 0; i < 16; ++i) {
+				largestDifference = std::max(largestDifference, std::abs(expected.values[i] - actual.values[i]));
+			}
+		}
+	}
+	bool passed = largestDifference < 1e-4f && badCopies == 0;
+	std::cout << "Transform hierarchy: largest difference " << largestDifference << ", " << badCopies << " bad copies"
+		<< (passed ? "" : " - MISMATCH!") << std::endl;
+
+	world.SetJobSystem(nullptr);
+	world.ClearAndErase();
+	for (GameObject* o : outside) {
+		delete o;
+	}
+	return passed;
+}
+
+/*
+TestTransformHierarchy again, on a few workers, and a check that ParallelFor
+hands every item out exactly once, whatever the range and batch sizes.
+*/
+bool TestParallelTransforms() {
+	JobSystem jobs(3);
+	bool passed = TestTransformHierarchy(&jobs);
+
+	std::mt19937 random(1234);
+	int badRanges = 0;
+	for (int i = 0; i < 200; ++i) {
+		size_t count	= random() % 5000;
+		size_t minBatch	= 1 + random() % 300;
+
+		vector<std::atomic<int>> visits(count);
+		for (auto& v : visits) {
+			v = 0;
+		}
+		jobs.ParallelFor(count, minBatch, [&visits](size_t first, size_t last) {
+			for (size_t j = first; j < last; ++j) {
+				visits[j]++;
+			}
+		});
+		for (auto& v : visits) {
+			if (v != 1) {
+				badRanges++;
+				break;
+			}
+		}
+	}
+	std::cout << "ParallelFor: " << badRanges << " bad ranges" << (badRanges == 0 ? "" : " - MISMATCH!") << std::endl;
+	return passed && badRanges == 0;
+}
+
+/*
+Checks that don't need a window or a game, so they can be run on their own
+(or from a build script) - returns non-zero if any of them fail.
+*/
+int main() {
+	bool passed = true;
+	passed = TestTransformHierarchy()	&& passed;
+	passed = TestParallelTransforms()	&& passed;
+
+	std::cout << (passed ? "All tests passed" : "Some tests FAILED") << std::endl;
+	return passed ? 0 : 1;
+}
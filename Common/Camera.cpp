@@ -57,9 +57,9 @@ straight to the shader...it's already an 'inverse camera' matrix.
 Matrix4 Camera::BuildViewMatrix() const {
 	//Why do a complicated matrix inversion, when we can just generate the matrix
 	//using the negative values ;). The matrix multiplication order is important!
-	return	Matrix4::Rotation(-pitch, Vector3(1, 0, 0)) *
-		Matrix4::Rotation(-yaw, Vector3(0, 1, 0)) *
-		Matrix4::Translation(-position);
+	return	Matrix4::Rotation(-pitch, Vector3(1, 0, 0)).AffineMultiply(
+		Matrix4::Rotation(-yaw, Vector3(0, 1, 0)).AffineMultiply(
+		Matrix4::Translation(-position)));
 };
 
 Matrix4 Camera::BuildProjectionMatrix(float currentAspect) const {
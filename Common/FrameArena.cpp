@@ -0,0 +1,81 @@
+#include "FrameArena.h"
+
+#include <algorithm>
+
+using namespace NCL;
+
+FrameArena::FrameArena(size_t blockSize) {
+	this->blockSize	= blockSize;
+	blockStart		= nullptr;
+	next			= nullptr;
+	end				= nullptr;
+	usedInOldBlocks = 0;
+	heapAllocations = 0;
+}
+
+FrameArena::~FrameArena() {
+	for (const Block& b : blocks) {
+		::operator delete(b.memory);
+	}
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment) {
+	char* aligned = (char*)(((size_t)next + alignment - 1) & ~(alignment - 1));
+
+	if (!next || aligned + size > end) {
+		AddBlock(size + alignment);
+		aligned = (char*)(((size_t)next + alignment - 1) & ~(alignment - 1));
+	}
+	next = aligned + size;
+	return aligned;
+}
+
+void FrameArena::AddBlock(size_t minSize) {
+	if (next) {
+		usedInOldBlocks += (size_t)(next - blockStart);
+	}
+	Block b;
+	b.size		= std::max(blockSize, minSize);
+	b.memory	= (char*)::operator new(b.size);
+	blocks.emplace_back(b);
+	heapAllocations++;
+
+	blockStart	= b.memory;
+	next		= b.memory;
+	end			= b.memory + b.size;
+}
+
+void FrameArena::Reset() {
+	if (blocks.size() > 1) { //outgrew the first block, so swap them all for one that would have fit everything
+		size_t total = GetCapacity();
+		for (const Block& b : blocks) {
+			::operator delete(b.memory);
+		}
+		blocks.clear();
+		blockStart	= nullptr;
+		next		= nullptr;
+		usedInOldBlocks = 0;
+		AddBlock(total);
+		return;
+	}
+	next			= blockStart;
+	usedInOldBlocks = 0;
+}
+
+void FrameArena::Swap(FrameArena& other) {
+	std::swap(blocks,			other.blocks);
+	std::swap(blockStart,		other.blockStart);
+	std::swap(next,				other.next);
+	std::swap(end,				other.end);
+	std::swap(usedInOldBlocks,	other.usedInOldBlocks);
+	std::swap(blockSize,		other.blockSize);
+	std::swap(heapAllocations,	other.heapAllocations);
+}
+
+size_t FrameArena::GetCapacity() const {
+	size_t total = 0;
+	for (const Block& b : blocks) {
+		total += b.size;
+	}
+	return total;
+}
\ No newline at end of file
@@ -0,0 +1,114 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace NCL {
+	/*
+	A linear allocator for temporaries that only live for a frame (or a
+	physics substep, or a single search). Allocating just bumps a pointer
+	along a block, nothing is freed on its own, and Reset throws the lot
+	away at once. No destructors are run, so anything put in here has to
+	be plain data, or a container that's destroyed before the Reset - some
+	standard libraries allocate even for an empty container, so keep them
+	local to the code between two Resets rather than holding on to them.
+
+	If a frame needs more than the block it has, more blocks are taken from
+	the heap, and the next Reset swaps them all for one block big enough
+	for the lot. After the first few frames of a steady workload, then, it
+	never touches the heap - GetHeapAllocations counts every time it does.
+
+	Not thread safe, so one per thread.
+	*/
+	class FrameArena	{
+	public:
+		FrameArena(size_t blockSize = 64 * 1024);
+		~FrameArena();
+
+		void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+		//Everything allocated so far is gone
+		void Reset();
+
+		void Swap(FrameArena& other);
+
+		//Since the last Reset
+		size_t GetBytesUsed() const {
+			return usedInOldBlocks + (size_t)(next - blockStart);
+		}
+
+		size_t GetCapacity() const;
+
+		//Over the arena's whole life
+		int GetHeapAllocations() const {
+			return heapAllocations;
+		}
+
+	protected:
+		FrameArena(const FrameArena&) = delete;
+		FrameArena& operator=(const FrameArena&) = delete;
+
+		void AddBlock(size_t minSize);
+
+		struct Block {
+			char*	memory;
+			size_t	size;
+		};
+		std::vector<Block>	blocks;			//the last one is being allocated from
+
+		char*	blockStart;
+		char*	next;
+		char*	end;
+		size_t	usedInOldBlocks;
+		size_t	blockSize;
+		int		heapAllocations;
+	};
+
+	/*
+	Lets the standard containers use a FrameArena. Deallocating is a no-op,
+	so anything a container frees (a vector that's grown, say) is only
+	reclaimed by the Reset. With no arena, it's just the heap.
+	*/
+	template <class T>
+	class FrameAllocator	{
+	public:
+		typedef T value_type;
+
+		FrameAllocator(FrameArena* arena = nullptr) : arena(arena) {
+		}
+
+		template <class U>
+		FrameAllocator(const FrameAllocator<U>& other) : arena(other.arena) {
+		}
+
+		T* allocate(size_t count) {
+			if (!arena) {
+				return (T*)::operator new(count * sizeof(T));
+			}
+			return (T*)arena->Allocate(count * sizeof(T), alignof(T));
+		}
+
+		void deallocate(T* p, size_t count) {
+			if (!arena) {
+				::operator delete(p);
+			}
+		}
+
+		FrameArena* arena;
+	};
+
+	template <class T, class U>
+	bool operator==(const FrameAllocator<T>& a, const FrameAllocator<U>& b) {
+		return a.arena == b.arena;
+	}
+
+	template <class T, class U>
+	bool operator!=(const FrameAllocator<T>& a, const FrameAllocator<U>& b) {
+		return a.arena != b.arena;
+	}
+
+	template <class T>
+	using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+	typedef std::basic_string<char, std::char_traits<char>, FrameAllocator<char>> FrameString;
+}
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+using namespace NCL;
+
+namespace {
+	//Which system, and which of its queues, the current thread owns
+	thread_local JobSystem* currentSystem	= nullptr;
+	thread_local int		currentQueue	= 0;
+}
+
+JobSystem::JobSystem(int workerCount) {
+	queuedJobs		= 0;
+	sleepingWorkers = 0;
+	threadAlive		= true;
+
+	for (int i = 0; i <= workerCount; ++i) {
+		queues.emplace_back(new JobQueue());
+	}
+	for (int i = 0; i < workerCount; ++i) {
+		workers.emplace_back(&JobSystem::WorkerThread, this, i + 1);
+	}
+}
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		threadAlive = false;
+	}
+	sleepReady.notify_all();
+
+	for (auto& i : workers) {
+		i.join();
+	}
+	for (auto& i : queues) {
+		delete i;
+	}
+}
+
+JobSystem& JobSystem::GetShared() {
+	static JobSystem shared(std::max((int)std::thread::hardware_concurrency() - 1, 0));
+	return shared;
+}
+
+int JobSystem::GetQueueIndex() const {
+	return currentSystem == this ? currentQueue : 0;
+}
+
+void JobSystem::Run(const JobFunc& func, JobCounter* signal, JobCounter* dependency) {
+	if (signal) {
+		signal->count++;
+	}
+	if (dependency) {
+		std::lock_guard<std::mutex> lock(dependency->mutex);
+		if (dependency->count > 0) {
+			dependency->waiting.push_back({ func, signal });
+			return; //Finish will push it once the dependency's done
+		}
+	}
+	Push({ func, signal });
+}
+
+void JobSystem::Push(Job&& job) {
+	JobQueue& queue = *queues[GetQueueIndex()];
+	queuedJobs++; //before it's visible, so this can only ever overcount
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.emplace_back(std::move(job));
+	}
+
+	if (sleepingWorkers > 0) {
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex); //so a worker that's about to sleep can't miss it
+		}
+		sleepReady.notify_one();
+	}
+}
+
+bool JobSystem::PopOrSteal(int queueIndex, Job& job) {
+	if (queuedJobs == 0) {
+		return false;
+	}
+	{
+		JobQueue& own = *queues[queueIndex];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.jobs.empty()) {
+			job = std::move(own.jobs.back()); //newest first - its data's most likely still in cache
+			own.jobs.pop_back();
+			queuedJobs--;
+			return true;
+		}
+	}
+	int queueCount = (int)queues.size();
+	for (int i = 1; i < queueCount; ++i) {
+		JobQueue& victim = *queues[(queueIndex + i) % queueCount];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.jobs.empty()) {
+			job = std::move(victim.jobs.front());
+			victim.jobs.pop_front();
+			queuedJobs--;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool JobSystem::RunOne(int queueIndex) {
+	Job job;
+	if (!PopOrSteal(queueIndex, job)) {
+		return false;
+	}
+	job.func();
+	Finish(job.signal);
+	return true;
+}
+
+void JobSystem::Finish(JobCounter* signal) {
+	if (!signal) {
+		return;
+	}
+	std::vector<JobCounter::WaitingJob> released;
+	{
+		//Done under the lock, so Wait can be sure we're finished with the counter
+		std::lock_guard<std::mutex> lock(signal->mutex);
+		if (--signal->count == 0) {
+			released.swap(signal->waiting);
+		}
+	}
+	for (auto& i : released) {
+		Push({ std::move(i.func), i.signal });
+	}
+}
+
+void JobSystem::Wait(JobCounter& counter) {
+	int queueIndex = GetQueueIndex();
+	while (counter.count > 0) {
+		if (!RunOne(queueIndex)) {
+			std::this_thread::yield(); //someone else has the last of them
+		}
+	}
+	std::lock_guard<std::mutex> lock(counter.mutex); //wait for the last Finish to let go of it
+}
+
+void JobSystem::ParallelFor(size_t count, size_t minBatch, const RangeFunc& func) {
+	if (count == 0) {
+		return;
+	}
+	size_t threads		= workers.size() + 1;
+	size_t batchSize	= std::max(minBatch, (count + threads * 4 - 1) / (threads * 4)); //a few each, so nobody's left waiting on one slow batch
+	batchSize			= std::max<size_t>(batchSize, 1);
+
+	if (workers.empty() || batchSize >= count) {
+		func(0, count);
+		return;
+	}
+	JobCounter counter;
+	for (size_t first = batchSize; first < count; first += batchSize) {
+		size_t last = std::min(first + batchSize, count);
+		Run([&func, first, last]() { func(first, last); }, &counter);
+	}
+	func(0, batchSize); //the first batch is ours, then we help with the rest
+	Wait(counter);
+}
+
+void JobSystem::WorkerThread(int index) {
+	currentSystem	= this;
+	currentQueue	= index;
+
+	while (threadAlive) {
+		if (RunOne(index)) {
+			continue;
+		}
+		for (int spin = 0; spin < 64 && queuedJobs == 0 && threadAlive; ++spin) {
+			std::this_thread::yield(); //more work's usually only a moment away
+		}
+		if (queuedJobs > 0) {
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleepingWorkers++;
+		sleepReady.wait(lock, [&] {
+			return !threadAlive || queuedJobs > 0;
+		});
+		sleepingWorkers--;
+	}
+}
\ No newline at end of file
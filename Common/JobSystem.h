@@ -0,0 +1,110 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace NCL {
+	typedef std::function<void()>						JobFunc;
+	typedef std::function<void(size_t first, size_t last)> RangeFunc;
+
+	class JobSystem;
+
+	/*
+	Counts jobs that haven't finished yet. Hand one to JobSystem::Run to have
+	it go up when the job's submitted and back down when it's done, then
+	Wait on it - or pass it as another job's dependency, and that job won't
+	start until the count gets back to zero.
+
+	Has to outlive the jobs using it - Waiting on it first is the easy way.
+	*/
+	class JobCounter	{
+	public:
+		JobCounter() {
+			count = 0;
+		}
+
+		bool IsDone() const {
+			return count == 0;
+		}
+
+	protected:
+		friend class JobSystem;
+
+		struct WaitingJob {
+			JobFunc		func;
+			JobCounter* signal;
+		};
+
+		std::atomic<int>		count;
+		std::mutex				mutex;
+		std::vector<WaitingJob> waiting;	//guarded by mutex, started when count hits zero
+	};
+
+	/*
+	Worker threads for the rest of the engine to share, rather than every
+	system starting up threads of its own. Every worker has its own queue
+	of jobs, which it works through newest first; once it runs out, it
+	steals the oldest jobs from everyone else's. Threads that aren't
+	workers (the main thread, say) share one more queue, and help out with
+	jobs of any kind whenever they Wait, so with no workers at all,
+	everything still gets done - just on the thread that waits for it.
+	*/
+	class JobSystem	{
+	public:
+		JobSystem(int workerCount);
+		~JobSystem();
+
+		//One worker per core, less one for the main thread
+		static JobSystem& GetShared();
+
+		int GetWorkerCount() const {
+			return (int)workers.size();
+		}
+
+		//Queues up func. If signal is given, it counts the job until it's done,
+		//and if dependency is given, the job doesn't start until that's done
+		void Run(const JobFunc& func, JobCounter* signal = nullptr, JobCounter* dependency = nullptr);
+
+		//Runs other jobs until the counter gets to zero
+		void Wait(JobCounter& counter);
+
+		//Calls func(first, last) for batches of at least minBatch items that
+		//between them cover [0, count), and returns once they've all finished
+		void ParallelFor(size_t count, size_t minBatch, const RangeFunc& func);
+
+	protected:
+		struct Job {
+			JobFunc		func;
+			JobCounter* signal;
+		};
+
+		//Owner pushes and pops at the back, thieves take from the front
+		struct JobQueue {
+			std::mutex		mutex;
+			std::deque<Job> jobs;
+		};
+
+		void WorkerThread(int index);
+
+		void Push(Job&& job);
+		bool RunOne(int queueIndex);
+		bool PopOrSteal(int queueIndex, Job& job);
+		void Finish(JobCounter* signal);
+
+		int GetQueueIndex() const;
+
+		std::vector<JobQueue*>	queues;		//0 is for anything that isn't a worker
+		std::atomic<int>		queuedJobs;	//across all of them
+
+		std::mutex				sleepMutex;
+		std::condition_variable sleepReady;
+		std::atomic<int>		sleepingWorkers;
+		std::atomic<bool>		threadAlive;
+
+		std::vector<std::thread> workers;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include "MappedFile.h"
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace NCL;
+
+MappedFile::MappedFile() {
+	data	= nullptr;
+	size	= 0;
+#ifdef _WIN32
+	fileHandle		= INVALID_HANDLE_VALUE;
+	mappingHandle	= nullptr;
+#else
+	fileHandle		= -1;
+#endif
+}
+
+MappedFile::MappedFile(const std::string& filepath) : MappedFile() {
+	Open(filepath);
+}
+
+MappedFile::~MappedFile() {
+	Close();
+}
+
+bool MappedFile::Open(const std::string& filepath) {
+	Close();
+#ifdef _WIN32
+	fileHandle = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE) {
+		std::cout << __FUNCTION__ << " can't open file " << filepath << std::endl;
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+		Close();
+		return false;
+	}
+	size = (size_t)fileSize.QuadPart;
+
+	mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	if (mappingHandle) {
+		data = (char*)MapViewOfFile(mappingHandle, FILE_MAP_COPY, 0, 0, 0);
+	}
+#else
+	fileHandle = open(filepath.c_str(), O_RDONLY);
+	if (fileHandle < 0) {
+		std::cout << __FUNCTION__ << " can't open file " << filepath << std::endl;
+		return false;
+	}
+	struct stat fileInfo;
+	if (fstat(fileHandle, &fileInfo) != 0 || fileInfo.st_size == 0) {
+		Close();
+		return false;
+	}
+	size = (size_t)fileInfo.st_size;
+
+	void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileHandle, 0);
+	if (view != MAP_FAILED) {
+		data = (char*)view;
+	}
+#endif
+	if (!data) {
+		std::cout << __FUNCTION__ << " can't map file " << filepath << std::endl;
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::Close() {
+#ifdef _WIN32
+	if (data) {
+		UnmapViewOfFile(data);
+	}
+	if (mappingHandle) {
+		CloseHandle(mappingHandle);
+	}
+	if (fileHandle != INVALID_HANDLE_VALUE) {
+		CloseHandle(fileHandle);
+	}
+	mappingHandle	= nullptr;
+	fileHandle		= INVALID_HANDLE_VALUE;
+#else
+	if (data) {
+		munmap(data, size);
+	}
+	if (fileHandle >= 0) {
+		close(fileHandle);
+	}
+	fileHandle		= -1;
+#endif
+	data	= nullptr;
+	size	= 0;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <string>
+
+namespace NCL {
+	/*
+	Maps a whole file into memory, so it can be used in place rather than
+	read in and parsed. The view is copy-on-write - writes through Data()
+	are private to this process and never make it back to the file.
+	*/
+	class MappedFile	{
+	public:
+		MappedFile();
+		MappedFile(const std::string& filepath);
+		~MappedFile();
+
+		bool Open(const std::string& filepath);
+		void Close();
+
+		bool IsOpen() const {
+			return data != nullptr;
+		}
+
+		char* Data() const {
+			return data;
+		}
+
+		size_t Size() const {
+			return size;
+		}
+
+	protected:
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		char*	data;
+		size_t	size;
+
+#ifdef _WIN32
+		void*	fileHandle;
+		void*	mappingHandle;
+#else
+		int		fileHandle;
+#endif
+	};
+}
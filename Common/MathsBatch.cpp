@@ -0,0 +1,194 @@
+#include "MathsBatch.h"
+#include "MathsSIMD.h"
+
+using namespace NCL;
+using namespace NCL::Maths;
+
+namespace {
+	//The same matrix as Quaternion::ToMatrix3, column major
+	inline void RotationMatrix(const Quaternion& q, float* m) {
+		float x2 = q.x + q.x;
+		float y2 = q.y + q.y;
+		float z2 = q.z + q.z;
+
+		float xx = q.x * x2;
+		float yy = q.y * y2;
+		float zz = q.z * z2;
+		float xy = q.x * y2;
+		float xz = q.x * z2;
+		float yz = q.y * z2;
+		float xw = q.w * x2;
+		float yw = q.w * y2;
+		float zw = q.w * z2;
+
+		m[0] = 1.0f - yy - zz;
+		m[1] = xy + zw;
+		m[2] = xz - yw;
+
+		m[3] = xy - zw;
+		m[4] = 1.0f - xx - zz;
+		m[5] = yz + xw;
+
+		m[6] = xz + yw;
+		m[7] = yz - xw;
+		m[8] = 1.0f - xx - yy;
+	}
+
+	inline void OBBToAABB(const Quaternion& q, const Vector3& halfSize, Vector3& out) {
+		float m[9];
+		RotationMatrix(q, m);
+
+		float x = halfSize.x;
+		float y = halfSize.y;
+		float z = halfSize.z;
+
+		out.x = std::abs(m[0]) * x + std::abs(m[3]) * y + std::abs(m[6]) * z;
+		out.y = std::abs(m[1]) * x + std::abs(m[4]) * y + std::abs(m[7]) * z;
+		out.z = std::abs(m[2]) * x + std::abs(m[5]) * y + std::abs(m[8]) * z;
+	}
+
+	inline void InverseInertiaTensor(const Quaternion& q, const Vector3& inverseInertia, Matrix3& out) {
+		float m[9];
+		RotationMatrix(q, m);
+
+		//D * R^T is just R's columns, scaled
+		float s[9];
+		for (int i = 0; i < 3; ++i) {
+			s[i]		= m[i]		* inverseInertia.x;
+			s[i + 3]	= m[i + 3]	* inverseInertia.y;
+			s[i + 6]	= m[i + 6]	* inverseInertia.z;
+		}
+
+		for (int c = 0; c < 3; ++c) {
+			for (int r = c; r < 3; ++r) { //it's symmetric, so only the lower half needs working out
+				float v = s[r] * m[c] + s[r + 3] * m[c + 3] + s[r + 6] * m[c + 6];
+				out.values[c * 3 + r] = v;
+				out.values[r * 3 + c] = v;
+			}
+		}
+	}
+
+#ifdef NCL_MATHS_SIMD
+	using namespace NCL::Maths::SIMD;
+
+	//4 quaternions in, a register each of their x, y, z and w
+	inline void LoadQuaternions(const Quaternion* q, Float4& x, Float4& y, Float4& z, Float4& w) {
+		x = Load(q[0].array);
+		y = Load(q[1].array);
+		z = Load(q[2].array);
+		w = Load(q[3].array);
+		Transpose(x, y, z, w);
+	}
+
+	//RotationMatrix, for 4 quaternions at once - m[i] holds value i of each of their matrices
+	inline void RotationMatrices(Float4 x, Float4 y, Float4 z, Float4 w, Float4* m) {
+		Float4 one = Splat(1.0f);
+
+		Float4 x2 = Add(x, x);
+		Float4 y2 = Add(y, y);
+		Float4 z2 = Add(z, z);
+
+		Float4 xx = Mul(x, x2);
+		Float4 yy = Mul(y, y2);
+		Float4 zz = Mul(z, z2);
+		Float4 xy = Mul(x, y2);
+		Float4 xz = Mul(x, z2);
+		Float4 yz = Mul(y, z2);
+		Float4 xw = Mul(w, x2);
+		Float4 yw = Mul(w, y2);
+		Float4 zw = Mul(w, z2);
+
+		m[0] = Sub(Sub(one, yy), zz);
+		m[1] = Add(xy, zw);
+		m[2] = Sub(xz, yw);
+
+		m[3] = Sub(xy, zw);
+		m[4] = Sub(Sub(one, xx), zz);
+		m[5] = Add(yz, xw);
+
+		m[6] = Add(xz, yw);
+		m[7] = Sub(yz, xw);
+		m[8] = Sub(Sub(one, xx), yy);
+	}
+
+	inline void StoreMatrix3s(Matrix3* out, const Float4* m) {
+		Float4 lo[4] = { m[0], m[1], m[2], m[3] };
+		Float4 hi[4] = { m[4], m[5], m[6], m[7] };
+		Transpose(lo[0], lo[1], lo[2], lo[3]);
+		Transpose(hi[0], hi[1], hi[2], hi[3]);
+
+		float last[4];
+		Store(last, m[8]);
+
+		for (int i = 0; i < 4; ++i) {
+			Store(out[i].values,		lo[i]);
+			Store(out[i].values + 4,	hi[i]);
+			out[i].values[8] = last[i];
+		}
+	}
+#endif
+}
+
+void Batch::OBBsToAABBs(const Quaternion* orientations, const Vector3* halfSizes, Vector3* out, size_t count) {
+	size_t i = 0;
+#ifdef NCL_MATHS_SIMD
+	for (; i + 4 <= count; i += 4) {
+		Float4 qx, qy, qz, qw;
+		LoadQuaternions(orientations + i, qx, qy, qz, qw);
+
+		Float4 m[9];
+		RotationMatrices(qx, qy, qz, qw, m);
+		for (int j = 0; j < 9; ++j) {
+			m[j] = Abs(m[j]);
+		}
+
+		Float4 x, y, z;
+		LoadVector3s(halfSizes[i].array, x, y, z);
+
+		Float4 ax = MulAdd(m[6], z, MulAdd(m[3], y, Mul(m[0], x)));
+		Float4 ay = MulAdd(m[7], z, MulAdd(m[4], y, Mul(m[1], x)));
+		Float4 az = MulAdd(m[8], z, MulAdd(m[5], y, Mul(m[2], x)));
+
+		StoreVector3s(out[i].array, ax, ay, az);
+	}
+#endif
+	for (; i < count; ++i) {
+		OBBToAABB(orientations[i], halfSizes[i], out[i]);
+	}
+}
+
+void Batch::InverseInertiaTensors(const Quaternion* orientations, const Vector3* inverseInertia, Matrix3* out, size_t count) {
+	size_t i = 0;
+#ifdef NCL_MATHS_SIMD
+	for (; i + 4 <= count; i += 4) {
+		Float4 qx, qy, qz, qw;
+		LoadQuaternions(orientations + i, qx, qy, qz, qw);
+
+		Float4 m[9];
+		RotationMatrices(qx, qy, qz, qw, m);
+
+		Float4 ix, iy, iz;
+		LoadVector3s(inverseInertia[i].array, ix, iy, iz);
+
+		Float4 s[9];
+		for (int j = 0; j < 3; ++j) {
+			s[j]		= Mul(m[j],		ix);
+			s[j + 3]	= Mul(m[j + 3], iy);
+			s[j + 6]	= Mul(m[j + 6], iz);
+		}
+
+		Float4 t[9];
+		for (int c = 0; c < 3; ++c) {
+			for (int r = c; r < 3; ++r) {
+				Float4 v = MulAdd(s[r + 6], m[c + 6], MulAdd(s[r + 3], m[c + 3], Mul(s[r], m[c])));
+				t[c * 3 + r] = v;
+				t[r * 3 + c] = v;
+			}
+		}
+		StoreMatrix3s(out + i, t);
+	}
+#endif
+	for (; i < count; ++i) {
+		InverseInertiaTensor(orientations[i], inverseInertia[i], out[i]);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+/*
+Array at a time versions of the maths that physics does once per object,
+every frame. Gathering everything up into flat arrays first and going
+through these is quicker than calling the single object versions in a
+loop, especially with NCL_MATHS_SIMD on, where four objects get done at
+once. Only the ones that measured faster are here - building transform
+matrices a batch at a time came out slower than Matrix4::TRS.
+*/
+#pragma once
+#include "Vector3.h"
+#include "Matrix3.h"
+#include "Quaternion.h"
+
+#include <cstddef>
+
+namespace NCL {
+	namespace Maths {
+		namespace Batch {
+			//World space half sizes of the boxes that fit around each OBB - the same
+			//as GameObject::UpdateBroadphaseAABB does for a single one
+			void OBBsToAABBs(const Quaternion* orientations, const Vector3* halfSizes, Vector3* out, size_t count);
+
+			//R * diag(inverseInertia) * R^T, as PhysicsObject::UpdateInertiaTensor does
+			void InverseInertiaTensors(const Quaternion* orientations, const Vector3* inverseInertia, Matrix3* out, size_t count);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,163 @@
+/*
+Opt-in SIMD paths for the maths classes. Define NCL_MATHS_SIMD below (or for
+every project in the solution - it changes the alignment of Matrix4, so
+everything has to agree on it) and the hot
+operations - Matrix4 * Matrix4, Matrix4 * Vector, Quaternion * Quaternion
+and Quaternion::Normalise - go through the Float4 functions here instead,
+as do the batch kernels in MathsBatch.h. The API doesn't change either way.
+
+Float4 is SSE on x86/x64 and NEON on ARM. Anywhere else, NCL_MATHS_SIMD is
+quietly turned back off, and everything stays scalar.
+*/
+#pragma once
+
+//#define NCL_MATHS_SIMD
+
+#ifdef NCL_MATHS_SIMD
+	#if defined(__ARM_NEON) || defined(_M_ARM64) || defined(_M_ARM)
+		#include <arm_neon.h>
+		#define NCL_SIMD_NEON
+	#elif defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		#include <xmmintrin.h>
+		#define NCL_SIMD_SSE
+	#else
+		#undef NCL_MATHS_SIMD
+	#endif
+#endif
+
+#ifdef NCL_MATHS_SIMD
+	#define NCL_SIMD_ALIGN alignas(16)
+#else
+	#define NCL_SIMD_ALIGN
+#endif
+
+#ifdef NCL_MATHS_SIMD
+namespace NCL {
+	namespace Maths {
+		namespace SIMD {
+#ifdef NCL_SIMD_SSE
+			typedef __m128 Float4;
+
+			//Nothing needs to be aligned to load or store
+			inline Float4	Load(const float* f)				{ return _mm_loadu_ps(f); }
+			inline void		Store(float* f, Float4 v)			{ _mm_storeu_ps(f, v); }
+			inline Float4	Splat(float f)						{ return _mm_set1_ps(f); }
+			inline Float4	Set(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+			inline float	GetX(Float4 v)						{ return _mm_cvtss_f32(v); }
+
+			inline Float4	Add(Float4 a, Float4 b)				{ return _mm_add_ps(a, b); }
+			inline Float4	Sub(Float4 a, Float4 b)				{ return _mm_sub_ps(a, b); }
+			inline Float4	Mul(Float4 a, Float4 b)				{ return _mm_mul_ps(a, b); }
+			inline Float4	MulAdd(Float4 a, Float4 b, Float4 c){ return _mm_add_ps(_mm_mul_ps(a, b), c); }
+
+			inline Float4	SwapPairs(Float4 v)					{ return _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)); }	//yxwz
+			inline Float4	SwapHalves(Float4 v)				{ return _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)); }	//zwxy
+			inline Float4	Reverse(Float4 v)					{ return _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3)); }	//wzyx
+
+			inline Float4	Abs(Float4 v)						{ return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+
+			//Rows in, columns out
+			inline void Transpose(Float4& a, Float4& b, Float4& c, Float4& d) {
+				_MM_TRANSPOSE4_PS(a, b, c, d);
+			}
+#endif
+#ifdef NCL_SIMD_NEON
+			typedef float32x4_t Float4;
+
+			inline Float4	Load(const float* f)				{ return vld1q_f32(f); }
+			inline void		Store(float* f, Float4 v)			{ vst1q_f32(f, v); }
+			inline Float4	Splat(float f)						{ return vdupq_n_f32(f); }
+			inline Float4	Set(float x, float y, float z, float w) { float f[4] = { x, y, z, w }; return vld1q_f32(f); }
+			inline float	GetX(Float4 v)						{ return vgetq_lane_f32(v, 0); }
+
+			inline Float4	Add(Float4 a, Float4 b)				{ return vaddq_f32(a, b); }
+			inline Float4	Sub(Float4 a, Float4 b)				{ return vsubq_f32(a, b); }
+			inline Float4	Mul(Float4 a, Float4 b)				{ return vmulq_f32(a, b); }
+			inline Float4	MulAdd(Float4 a, Float4 b, Float4 c){ return vmlaq_f32(c, a, b); }
+
+			inline Float4	SwapPairs(Float4 v)					{ return vrev64q_f32(v); }
+			inline Float4	SwapHalves(Float4 v)				{ return vextq_f32(v, v, 2); }
+			inline Float4	Reverse(Float4 v)					{ return vrev64q_f32(vextq_f32(v, v, 2)); }
+
+			inline Float4	Abs(Float4 v)						{ return vabsq_f32(v); }
+
+			inline void Transpose(Float4& a, Float4& b, Float4& c, Float4& d) {
+				float32x4x2_t ab = vtrnq_f32(a, b);
+				float32x4x2_t cd = vtrnq_f32(c, d);
+				a = vcombine_f32(vget_low_f32(ab.val[0]),	vget_low_f32(cd.val[0]));
+				b = vcombine_f32(vget_low_f32(ab.val[1]),	vget_low_f32(cd.val[1]));
+				c = vcombine_f32(vget_high_f32(ab.val[0]),	vget_high_f32(cd.val[0]));
+				d = vcombine_f32(vget_high_f32(ab.val[1]),	vget_high_f32(cd.val[1]));
+			}
+#endif
+			//Every lane ends up holding the sum of all four
+			inline Float4 HorizontalAdd(Float4 v) {
+				v = Add(v, SwapPairs(v));
+				return Add(v, SwapHalves(v));
+			}
+
+			inline Float4 Dot4(Float4 a, Float4 b) {
+				return HorizontalAdd(Mul(a, b));
+			}
+
+			//Splits 4 packed Vector3s (12 floats) into a register each of x, y and z
+			inline void LoadVector3s(const float* f, Float4& x, Float4& y, Float4& z) {
+				Float4 a = Load(f);
+				Float4 b = Load(f + 3);
+				Float4 c = Load(f + 6);
+				Float4 d = Set(f[9], f[10], f[11], 0.0f); //a full load would run off the end
+				Transpose(a, b, c, d);
+				x = a;
+				y = b;
+				z = c;
+			}
+
+			//...and back again. Everything is loaded before anything is stored, so in place is fine
+			inline void StoreVector3s(float* f, Float4 x, Float4 y, Float4 z) {
+				Float4 w = Splat(0.0f);
+				Transpose(x, y, z, w);
+				Store(f, x);
+				Store(f + 3, y);	//each overwrites the junk w of the one before
+				Store(f + 6, z);
+				float last[4];
+				Store(last, w);
+				f[9]	= last[0];
+				f[10]	= last[1];
+				f[11]	= last[2];
+			}
+
+			//out = a * b, for column major 4x4 matrices
+			inline void MultiplyMatrices(const float* a, const float* b, float* out) {
+				Float4 c0 = Load(a);
+				Float4 c1 = Load(a + 4);
+				Float4 c2 = Load(a + 8);
+				Float4 c3 = Load(a + 12);
+
+				for (int i = 0; i < 16; i += 4) { //each column of b picks a mix of a's columns
+					Float4 column = Mul(c0, Splat(b[i]));
+					column = MulAdd(c1, Splat(b[i + 1]), column);
+					column = MulAdd(c2, Splat(b[i + 2]), column);
+					column = MulAdd(c3, Splat(b[i + 3]), column);
+					Store(out + i, column);
+				}
+			}
+
+			inline Float4 TransformVector(const float* m, float x, float y, float z, float w) {
+				Float4 result = Mul(Load(m), Splat(x));
+				result = MulAdd(Load(m + 4), Splat(y), result);
+				result = MulAdd(Load(m + 8), Splat(z), result);
+				return MulAdd(Load(m + 12), Splat(w), result);
+			}
+
+			//Quaternions as xyzw, returns a * b
+			inline Float4 MultiplyQuaternions(const float* a, const float* b) {
+				Float4 q		= Load(b);
+				Float4 result	= Mul(Splat(a[3]), q);
+				result = MulAdd(Splat(a[0]), Mul(Reverse(q),	Set( 1.0f, -1.0f,  1.0f, -1.0f)), result);
+				result = MulAdd(Splat(a[1]), Mul(SwapHalves(q), Set( 1.0f,  1.0f, -1.0f, -1.0f)), result);
+				return	 MulAdd(Splat(a[2]), Mul(SwapPairs(q),	Set(-1.0f,  1.0f,  1.0f, -1.0f)), result);
+			}
+		}
+	}
+}
+#endif
\ No newline at end of file
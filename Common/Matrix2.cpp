@@ -4,16 +4,6 @@
 using namespace NCL;
 using namespace NCL::Maths;
 
-Matrix2::Matrix2(void)	{
-	values[0] = 1.0f;
-	values[1] = 0.0f;
-	values[2] = 0.0f;
-	values[3] = 1.0f;
-}
-
-Matrix2::~Matrix2(void)	{
-}
-
 void Matrix2::ToZero() {
 	values[0] = 0.0f;
 	values[1] = 0.0f;
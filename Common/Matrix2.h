@@ -1,14 +1,29 @@
 #pragma once
 #include "Vector2.h"
 #include <assert.h>
+#include <type_traits>
 namespace NCL {
 	namespace Maths {
 		class Matrix2 {
 		public:
-			Matrix2(void);
+			//Identity
+			constexpr Matrix2(void) : values{
+				1.0f, 0.0f,
+				0.0f, 1.0f } {
+			}
 			Matrix2(float elements[4]);
 
-			~Matrix2(void);
+			static constexpr Matrix2 Identity() {
+				return Matrix2();
+			}
+
+			static constexpr Matrix2 Zero() {
+				Matrix2 m;
+				for (int i = 0; i < 4; ++i) {
+					m.values[i] = 0.0f;
+				}
+				return m;
+			}
 
 			void ToZero();
 			void ToIdentity();
@@ -80,5 +95,8 @@ namespace NCL {
 			o << "\t\t" << m.values[1] << "," << m.values[3] << std::endl;
 			return o;
 		}
+
+		static_assert(std::is_trivially_copyable<Matrix2>::value, "Matrix2 must be trivially copyable");
+		static_assert(sizeof(Matrix2) == sizeof(float) * 4, "Matrix2 must be tightly packed");
 	}
 }
\ No newline at end of file
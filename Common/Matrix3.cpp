@@ -3,9 +3,6 @@
 #include "Vector3.h"
 using namespace NCL;
 using namespace NCL::Maths;
-Matrix3::Matrix3(void)	{
-	ToIdentity();
-}
 
 Matrix3::Matrix3(float elements[16]) {
 	values[0] = elements[0];
@@ -36,10 +33,6 @@ Matrix3::Matrix3(const Matrix4 &m4) {
 }
 
 
-Matrix3::~Matrix3(void)	{
-
-}
-
 Matrix3 Matrix3::Rotation(float degrees, const Vector3 &inaxis)	 {
 	Matrix3 m;
 
@@ -78,7 +71,7 @@ Matrix3 Matrix3::Scale( const Vector3 &scale )	{
 
 void	Matrix3::ToZero()	{
 	for(int i = 0; i < 9; ++i) {
-		values[0] = 0.0f;
+		values[i] = 0.0f;
 	}
 }
 
@@ -1,17 +1,33 @@
 #pragma once
 #include "Matrix4.h"
 #include <assert.h>
+#include <type_traits>
 
 namespace NCL {
 	namespace Maths {
 		class Matrix3
 		{
 		public:
-			Matrix3(void);
+			//Identity
+			constexpr Matrix3(void) : values{
+				1.0f, 0.0f, 0.0f,
+				0.0f, 1.0f, 0.0f,
+				0.0f, 0.0f, 1.0f } {
+			}
 			Matrix3(float elements[16]);
 			Matrix3(const Matrix4 &m4);
 
-			~Matrix3(void);
+			static constexpr Matrix3 Identity() {
+				return Matrix3();
+			}
+
+			static constexpr Matrix3 Zero() {
+				Matrix3 m;
+				for (int i = 0; i < 9; ++i) {
+					m.values[i] = 0.0f;
+				}
+				return m;
+			}
 
 			//Set all matrix values to zero
 			void	ToZero();
@@ -160,5 +176,8 @@ namespace NCL {
 
 			return i;
 		}
+
+		static_assert(std::is_trivially_copyable<Matrix3>::value, "Matrix3 must be trivially copyable");
+		static_assert(sizeof(Matrix3) == sizeof(float) * 9, "Matrix3 must be tightly packed");
 	}
 }
\ No newline at end of file
@@ -1,12 +1,10 @@
 #include "Matrix4.h"
 #include "Matrix3.h"
+#include "Quaternion.h"
 #include "Maths.h"
 
 using namespace NCL;
 using namespace NCL::Maths;
-Matrix4::Matrix4(void)	{
-	ToIdentity();
-}
 
 Matrix4::Matrix4( float elements[16] )	{
 	memcpy(this->values,elements,16*sizeof(float));
@@ -29,10 +27,6 @@ Matrix4::Matrix4(const Matrix3& m3) {
 	values[15] = 1.0f;
 }
 
-Matrix4::~Matrix4(void)	{
-	ToIdentity();
-}
-
 void Matrix4::ToIdentity() {
 	ToZero();
 	values[0]  = 1.0f;
@@ -100,9 +94,6 @@ Matrix4 Matrix4::Orthographic(float znear, float zfar,float right, float left, f
 }
 
 Matrix4 Matrix4::BuildViewMatrix(const Vector3 &from, const Vector3 &lookingAt, const Vector3 up /*= Vector3(1,0,0)*/ )	{
-	Matrix4 r;
-	r.SetPositionVector(Vector3(-from.x,-from.y,-from.z));
-
 	Matrix4 m;
 
 	Vector3 f = (lookingAt - from);
@@ -123,7 +114,12 @@ Matrix4 Matrix4::BuildViewMatrix(const Vector3 &from, const Vector3 &lookingAt,
 	m.values[6]  = -f.y;
 	m.values[10] = -f.z;
 
-	return m*r;
+	//The rotation above * Translation(-from), without doing the multiply
+	m.values[12] = -Vector3::Dot(s, from);
+	m.values[13] = -Vector3::Dot(u, from);
+	m.values[14] =  Vector3::Dot(f, from);
+
+	return m;
 }
 
 Matrix4 Matrix4::Rotation(float degrees, const Vector3 &inaxis)	 {
@@ -252,4 +248,104 @@ Matrix4 Matrix4::Inverse()	const {
 
 	return mat;
 
+}
+
+Matrix4 Matrix4::TRS(const Vector3& translation, const Quaternion& rotation, const Vector3& scale) {
+	Matrix4 m;
+
+	float x2 = rotation.x + rotation.x;
+	float y2 = rotation.y + rotation.y;
+	float z2 = rotation.z + rotation.z;
+
+	float xx = rotation.x * x2;
+	float yy = rotation.y * y2;
+	float zz = rotation.z * z2;
+	float xy = rotation.x * y2;
+	float xz = rotation.x * z2;
+	float yz = rotation.y * z2;
+	float xw = rotation.w * x2;
+	float yw = rotation.w * y2;
+	float zw = rotation.w * z2;
+
+	//Rotation columns, each scaled by its axis
+	m.values[0]		= (1.0f - yy - zz)	* scale.x;
+	m.values[1]		= (xy + zw)			* scale.x;
+	m.values[2]		= (xz - yw)			* scale.x;
+	m.values[3]		= 0.0f;
+
+	m.values[4]		= (xy - zw)			* scale.y;
+	m.values[5]		= (1.0f - xx - zz)	* scale.y;
+	m.values[6]		= (yz + xw)			* scale.y;
+	m.values[7]		= 0.0f;
+
+	m.values[8]		= (xz + yw)			* scale.z;
+	m.values[9]		= (yz - xw)			* scale.z;
+	m.values[10]	= (1.0f - xx - yy)	* scale.z;
+	m.values[11]	= 0.0f;
+
+	m.values[12]	= translation.x;
+	m.values[13]	= translation.y;
+	m.values[14]	= translation.z;
+	m.values[15]	= 1.0f;
+
+	return m;
+}
+
+Matrix4 Matrix4::RigidInverse() const {
+	Matrix4 m;
+
+	m.values[0]		= values[0];
+	m.values[1]		= values[4];
+	m.values[2]		= values[8];
+	m.values[3]		= 0.0f;
+
+	m.values[4]		= values[1];
+	m.values[5]		= values[5];
+	m.values[6]		= values[9];
+	m.values[7]		= 0.0f;
+
+	m.values[8]		= values[2];
+	m.values[9]		= values[6];
+	m.values[10]	= values[10];
+	m.values[11]	= 0.0f;
+
+	//-(R^T * t) - each is the dot product of one of the old columns with t
+	float tx = values[12];
+	float ty = values[13];
+	float tz = values[14];
+
+	m.values[12]	= -(values[0] * tx + values[1] * ty + values[2]  * tz);
+	m.values[13]	= -(values[4] * tx + values[5] * ty + values[6]  * tz);
+	m.values[14]	= -(values[8] * tx + values[9] * ty + values[10] * tz);
+	m.values[15]	= 1.0f;
+
+	return m;
+}
+
+Matrix4 Matrix4::AffineMultiply(const Matrix4& a) const {
+#ifdef NCL_MATHS_SIMD
+	return *this * a; //the full multiply is already only 16 vector multiply-adds
+#else
+	Matrix4 out;
+	const float* m = values;
+
+	for (int c = 0; c < 4; ++c) {
+		const float* in = &a.values[c * 4];
+		float* o = &out.values[c * 4];
+
+		o[0] = m[0] * in[0] + m[4] * in[1] + m[8]  * in[2];
+		o[1] = m[1] * in[0] + m[5] * in[1] + m[9]  * in[2];
+		o[2] = m[2] * in[0] + m[6] * in[1] + m[10] * in[2];
+	}
+	out.values[3]	= 0.0f;
+	out.values[7]	= 0.0f;
+	out.values[11]	= 0.0f;
+
+	out.values[12] += m[12];
+	out.values[13] += m[13];
+	out.values[14] += m[14];
+	out.values[15] = 1.0f;
+
+	return out;
+#endif
 }
\ No newline at end of file
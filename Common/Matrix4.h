@@ -16,23 +16,43 @@ _-_-_-_-_-_-_-""  ""
 #pragma once
 
 #include <iostream>
+#include <type_traits>
 #include "Vector3.h"
 #include "Vector4.h"
+#include "MathsSIMD.h"
 
 namespace NCL {
 	namespace Maths {
 		class Vector3;
 		class Matrix3;
+		class Quaternion;
 
-		class Matrix4 {
+		class NCL_SIMD_ALIGN Matrix4 {
 		public:
-			Matrix4(void);
+			//Identity
+			constexpr Matrix4(void) : values{
+				1.0f, 0.0f, 0.0f, 0.0f,
+				0.0f, 1.0f, 0.0f, 0.0f,
+				0.0f, 0.0f, 1.0f, 0.0f,
+				0.0f, 0.0f, 0.0f, 1.0f } {
+			}
 			Matrix4(float elements[16]);
 			Matrix4(const Matrix3& m3);
-			~Matrix4(void);
 
 			float	values[16];
 
+			static constexpr Matrix4 Identity() {
+				return Matrix4();
+			}
+
+			static constexpr Matrix4 Zero() {
+				Matrix4 m;
+				for (int i = 0; i < 16; ++i) {
+					m.values[i] = 0.0f;
+				}
+				return m;
+			}
+
 			//Set all matrix values to zero
 			void	ToZero();
 			//Sets matrix to identity matrix (1.0 down the diagonal)
@@ -74,8 +94,22 @@ namespace NCL {
 			//'up' as the...up axis (pointing towards the top of the screen)
 			static Matrix4 BuildViewMatrix(const Vector3 &from, const Vector3 &lookingAt, const Vector3 up = Vector3(0, 1, 0));
 
+			//Same as Translation(translation) * rotation.ToMatrix4() * Scale(scale), without
+			//building three matrices and multiplying them together to get it
+			static Matrix4 TRS(const Vector3& translation, const Quaternion& rotation, const Vector3& scale);
+
+			//Full inverse - works on anything, but it's slow. If the matrix is only
+			//rotation and translation (view matrices, unscaled objects), use RigidInverse
 			Matrix4 Inverse() const;
 
+			//Inverse of a rotation + translation matrix: the rotation is just
+			//transposed, and the translation rotated back and negated
+			Matrix4 RigidInverse() const;
+
+			//this * a, where both are affine (bottom row of 0,0,0,1 - anything built
+			//from Translation, Rotation, Scale and TRS), so the bottom row can be skipped
+			Matrix4 AffineMultiply(const Matrix4& a) const;
+
 			Vector4 GetRow(unsigned int row)const {
 				Vector4 out(0, 0, 0, 1);
 				if (row <= 3) {
@@ -102,6 +136,9 @@ namespace NCL {
 			//Multiplies 'this' matrix by matrix 'a'. Performs the multiplication in 'OpenGL' order (ie, backwards)
 			inline Matrix4 operator*(const Matrix4 &a) const {
 				Matrix4 out;
+#ifdef NCL_MATHS_SIMD
+				SIMD::MultiplyMatrices(values, a.values, out.values);
+#else
 				//Students! You should be able to think up a really easy way of speeding this up...
 				for (unsigned int r = 0; r < 4; ++r) {
 					for (unsigned int c = 0; c < 4; ++c) {
@@ -111,10 +148,17 @@ namespace NCL {
 						}
 					}
 				}
+#endif
 				return out;
 			}
 
 			inline Vector3 operator*(const Vector3 &v) const {
+#ifdef NCL_MATHS_SIMD
+				float result[4];
+				SIMD::Store(result, SIMD::TransformVector(values, v.x, v.y, v.z, 1.0f));
+				float invW = 1.0f / result[3];
+				return Vector3(result[0] * invW, result[1] * invW, result[2] * invW);
+#else
 				Vector3 vec;
 
 				float temp;
@@ -130,15 +174,22 @@ namespace NCL {
 				vec.z = vec.z / temp;
 
 				return vec;
+#endif
 			};
 
 			inline Vector4 operator*(const Vector4 &v) const {
+#ifdef NCL_MATHS_SIMD
+				Vector4 out;
+				SIMD::Store(&out.x, SIMD::TransformVector(values, v.x, v.y, v.z, v.w));
+				return out;
+#else
 				return Vector4(
 					v.x*values[0] + v.y*values[4] + v.z*values[8] + v.w * values[12],
 					v.x*values[1] + v.y*values[5] + v.z*values[9] + v.w * values[13],
 					v.x*values[2] + v.y*values[6] + v.z*values[10] + v.w * values[14],
 					v.x*values[3] + v.y*values[7] + v.z*values[11] + v.w * values[15]
 				);
+#endif
 			};
 
 			//Handy string output for the matrix. Can get a bit messy, but better than nothing!
@@ -151,5 +202,9 @@ namespace NCL {
 				return o;
 			}
 		};
+
+		//Uploaded straight to uniforms, and copied around by value everywhere
+		static_assert(std::is_trivially_copyable<Matrix4>::value, "Matrix4 must be trivially copyable");
+		static_assert(sizeof(Matrix4) == sizeof(float) * 16, "Matrix4 must be tightly packed");
 	}
 }
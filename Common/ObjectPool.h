@@ -0,0 +1,207 @@
+#pragma once
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <cassert>
+#include <thread>
+
+namespace NCL {
+	/*
+	Recycles memory for objects of one type that come and go a lot - the
+	things in a level, say, which are all thrown away and made again every
+	time it restarts. Objects live in chunks of ChunkSize, so they sit next
+	to each other in memory, and never move once they're made. Freed slots
+	are reused before any new chunk is taken from the heap, and once the
+	pool's empty, it hands slots out in order again, from the first chunk.
+
+	Every slot has a generation, which goes up whenever the slot's used or
+	freed, so a Handle (a slot index plus the generation it had) can tell
+	if its object's gone - unlike a pointer, which would carry on pointing
+	at whatever was made in the slot next.
+
+	Not thread safe - whichever thread first takes a slot from a pool is the
+	only one that should use it after that, which debug builds check. Objects
+	left in it when it's destroyed are never destructed.
+	*/
+	template <class T, size_t ChunkSize = 256>
+	class ObjectPool	{
+	public:
+		struct Handle {
+			unsigned int index		= 0;
+			unsigned int generation	= 0;	//live objects are always odd, so the default Handle never matches
+
+			bool operator==(const Handle& other) const {
+				return index == other.index && generation == other.generation;
+			}
+
+			bool operator!=(const Handle& other) const {
+				return !(*this == other);
+			}
+		};
+
+		ObjectPool() {
+			liveCount			= 0;
+			chunkAllocations	= 0;
+		}
+
+		~ObjectPool() {
+			for (Chunk& c : chunks) {
+				::operator delete(c.memory);
+			}
+		}
+
+		template <class... Args>
+		T* Create(Args&&... args) {
+			return new (Allocate()) T(std::forward<Args>(args)...);
+		}
+
+		void Destroy(T* object) {
+			object->~T();
+			Free(object);
+		}
+
+		//Room for one T - it's up to the caller to construct it
+		void* Allocate() {
+			CheckThread();
+			if (freeSlots.empty()) {
+				AddChunk();
+			}
+			unsigned int index = freeSlots.back();
+			freeSlots.pop_back();
+
+			chunks[index / ChunkSize].generations[index % ChunkSize]++;
+			liveCount++;
+			return SlotAddress(index);
+		}
+
+		//Must have come from Allocate, and anything in it already destructed
+		void Free(void* p) {
+			CheckThread();
+			unsigned int index = IndexOf(p);
+			chunks[index / ChunkSize].generations[index % ChunkSize]++;
+			freeSlots.emplace_back(index);
+
+			if (--liveCount == 0) { //start filling from the front again
+				for (unsigned int i = 0; i < freeSlots.size(); ++i) {
+					freeSlots[i] = (unsigned int)freeSlots.size() - 1 - i;
+				}
+			}
+		}
+
+		bool Owns(const void* p) const {
+			return FindChunk(p) < chunks.size();
+		}
+
+		//An empty Handle if p isn't one of ours
+		Handle GetHandle(const T* p) const {
+			Handle h;
+			if (Owns(p)) {
+				h.index			= IndexOf(p);
+				h.generation	= chunks[h.index / ChunkSize].generations[h.index % ChunkSize];
+			}
+			return h;
+		}
+
+		//Null if the object's been freed since
+		T* Get(const Handle& h) const {
+			if ((h.generation & 1) == 0 || h.index / ChunkSize >= chunks.size()) {
+				return nullptr;
+			}
+			if (chunks[h.index / ChunkSize].generations[h.index % ChunkSize] != h.generation) {
+				return nullptr;
+			}
+			return (T*)SlotAddress(h.index);
+		}
+
+		size_t GetLiveCount() const {
+			return liveCount;
+		}
+
+		size_t GetCapacity() const {
+			return chunks.size() * ChunkSize;
+		}
+
+		//Over the pool's whole life
+		int GetChunkAllocations() const {
+			return chunkAllocations;
+		}
+
+	protected:
+		ObjectPool(const ObjectPool&) = delete;
+		ObjectPool& operator=(const ObjectPool&) = delete;
+
+		struct Chunk {
+			void*			memory;
+			char*			slots;		//memory, aligned for T
+			unsigned int	generations[ChunkSize];
+		};
+
+		void AddChunk() {
+			chunks.emplace_back();
+			Chunk& c = chunks.back();
+
+			c.memory	= ::operator new(sizeof(T) * ChunkSize + alignof(T));
+			c.slots		= (char*)(((size_t)c.memory + alignof(T) - 1) & ~(alignof(T) - 1));
+			for (unsigned int& g : c.generations) {
+				g = 0;
+			}
+			chunkAllocations++;
+
+			unsigned int first = (unsigned int)((chunks.size() - 1) * ChunkSize);
+			for (unsigned int i = ChunkSize; i > 0; --i) {
+				freeSlots.emplace_back(first + i - 1); //so the lowest comes out first
+			}
+
+			size_t chunk = chunks.size() - 1;
+			chunksByAddress.insert(std::upper_bound(chunksByAddress.begin(), chunksByAddress.end(), chunk,
+				[this](size_t a, size_t b) {
+					return std::less<const char*>()(chunks[a].slots, chunks[b].slots);
+				}), chunk);
+		}
+
+		void CheckThread() {
+#ifndef NDEBUG
+			if (owner == std::thread::id()) {
+				owner = std::this_thread::get_id();
+			}
+			assert(owner == std::this_thread::get_id());
+#endif
+		}
+
+		void* SlotAddress(unsigned int index) const {
+			return chunks[index / ChunkSize].slots + (index % ChunkSize) * sizeof(T);
+		}
+
+		//Every delete asks this, so it's a binary search on where the chunks start
+		size_t FindChunk(const void* p) const {
+			const char* c = (const char*)p;
+			auto after = std::upper_bound(chunksByAddress.begin(), chunksByAddress.end(), c,
+				[this](const char* address, size_t chunk) {
+					return std::less<const char*>()(address, chunks[chunk].slots);
+				});
+			if (after == chunksByAddress.begin()) {
+				return chunks.size();
+			}
+			size_t i = *(after - 1);
+			if (std::less<const char*>()(c, chunks[i].slots + sizeof(T) * ChunkSize)) {
+				return i;
+			}
+			return chunks.size();
+		}
+
+		unsigned int IndexOf(const void* p) const {
+			size_t chunk = FindChunk(p);
+			size_t slot	 = ((const char*)p - chunks[chunk].slots) / sizeof(T);
+			return (unsigned int)(chunk * ChunkSize + slot);
+		}
+
+		std::vector<Chunk>			chunks;
+		std::vector<size_t>			chunksByAddress;
+		std::vector<unsigned int>	freeSlots;	//the back one's used next
+		size_t						liveCount;
+		int							chunkAllocations;
+		std::thread::id				owner;		//the first thread to take a slot, or none yet
+	};
+}
\ No newline at end of file
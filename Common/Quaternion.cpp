@@ -6,36 +6,18 @@
 using namespace NCL;
 using namespace NCL::Maths;
 
-Quaternion::Quaternion(void)
-{
-	x = y = z = 0.0f;
-	w = 1.0f;
-}
-
-Quaternion::Quaternion(float x, float y, float z, float w)
-{
-	this->x = x;
-	this->y = y;
-	this->z = z;
-	this->w = w;
-}
-
-Quaternion::Quaternion(const Vector3& vector, float w) {
-	this->x = vector.x;
-	this->y = vector.y;
-	this->z = vector.z;
-	this->w = w;
-}
-
-Quaternion::~Quaternion(void)
-{
-}
-
 float Quaternion::Dot(const Quaternion &a,const Quaternion &b){
 	return (a.x * b.x) + (a.y * b.y) + (a.z * b.z) + (a.w * b.w);
 }
 
 void Quaternion::Normalise(){
+#ifdef NCL_MATHS_SIMD
+	SIMD::Float4 q = SIMD::Load(array);
+	float lengthSq = SIMD::GetX(SIMD::Dot4(q, q));
+	if (lengthSq > 0.0f) {
+		SIMD::Store(array, SIMD::Mul(q, SIMD::Splat(1.0f / sqrt(lengthSq))));
+	}
+#else
 	float magnitude = sqrt(x*x + y*y + z*z + w*w);
 
 	if(magnitude > 0.0f){
@@ -46,10 +28,36 @@ void Quaternion::Normalise(){
 		z *= t;
 		w *= t;
 	}
+#endif
 }
 
+//Straight into the 4x4, rather than via a Matrix3 that then has to be copied across
 Matrix4 Quaternion::ToMatrix4() const{
-	return Matrix4(ToMatrix3());
+	Matrix4 mat;
+
+	float yy = y*y;
+	float zz = z*z;
+	float xy = x*y;
+	float zw = z*w;
+	float xz = x*z;
+	float yw = y*w;
+	float xx = x*x;
+	float yz = y*z;
+	float xw = x*w;
+
+	mat.values[0]	= 1 - 2 * yy - 2 * zz;
+	mat.values[1]	= 2 * xy + 2 * zw;
+	mat.values[2]	= 2 * xz - 2 * yw;
+
+	mat.values[4]	= 2 * xy - 2 * zw;
+	mat.values[5]	= 1 - 2 * xx - 2 * zz;
+	mat.values[6]	= 2 * yz + 2 * xw;
+
+	mat.values[8]	= 2 * xz + 2 * yw;
+	mat.values[9]	= 2 * yz - 2 * xw;
+	mat.values[10]	= 1 - 2 * xx - 2 * yy;
+
+	return mat;
 }
 
 Matrix3 Quaternion::ToMatrix3() const {
@@ -205,9 +213,19 @@ Quaternion Quaternion::Slerp(const Quaternion &from, const Quaternion &to, float
 
 	if(dot < 0.0f) {
 		temp = -to;
+		dot = -dot;
 	}
 
-	return (from * (cos(by))) + (to * (1.0f - cos(by)));
+	if(dot > 0.9995f) { //so close together that sin(angle) is no use, but lerping is fine
+		Quaternion result = Lerp(from, temp, by);
+		result.Normalise();
+		return result;
+	}
+
+	float angle		= acos(std::min(dot, 1.0f));
+	float sinAngle	= sin(angle);
+
+	return (from * (sin((1.0f - by) * angle) / sinAngle)) + (temp * (sin(by * angle) / sinAngle));
 }
 
 //http://en.wikipedia.org/wiki/Conversion_between_quaternions_and_Euler_angles
@@ -21,11 +21,14 @@ _-_-_-_-_-_-_-""  ""
 #pragma once
 #include "Matrix4.h"
 #include "Matrix3.h"
+#include <type_traits>
 
 namespace NCL {
 	namespace Maths {
 		class Matrix4;
 
+		//Never over-aligned, even with NCL_MATHS_SIMD - network packets hold them,
+		//and those get read straight out of byte buffers, at any offset
 		class Quaternion {
 		public:
 			union {
@@ -38,11 +41,17 @@ namespace NCL {
 				float array[4];
 			};
 		public:
-			Quaternion(void);
-			Quaternion(float x, float y, float z, float w);
-			Quaternion(const Vector3& vector, float w);
+			//Identity
+			constexpr Quaternion(void) : array{ 0.0f, 0.0f, 0.0f, 1.0f } {
+			}
+			constexpr Quaternion(float x, float y, float z, float w) : array{ x, y, z, w } {
+			}
+			Quaternion(const Vector3& vector, float w) : array{ vector.x, vector.y, vector.z, w } {
+			}
 
-			~Quaternion(void);
+			static constexpr Quaternion Identity() {
+				return Quaternion();
+			}
 
 			void	Normalise();
 			Matrix4 ToMatrix4() const;
@@ -85,12 +94,18 @@ namespace NCL {
 			}
 
 			inline Quaternion  operator *(const Quaternion &b)	const {
+#ifdef NCL_MATHS_SIMD
+				Quaternion out;
+				SIMD::Store(out.array, SIMD::MultiplyQuaternions(array, b.array));
+				return out;
+#else
 				return Quaternion(
 					(x * b.w) + (w * b.x) + (y * b.z) - (z * b.y),
 					(y * b.w) + (w * b.y) + (z * b.x) - (x * b.z),
 					(z * b.w) + (w * b.z) + (x * b.y) - (y * b.x),
 					(w * b.w) - (x * b.x) - (y * b.y) - (z * b.z)
 				);
+#endif
 			}
 
 			inline Vector3		operator *(const Vector3 &a)	const {
@@ -162,6 +177,9 @@ namespace NCL {
 			inline friend std::istream& operator >> (std::istream& i, Quaternion &v);
 		};
 
+		static_assert(std::is_trivially_copyable<Quaternion>::value, "Quaternion must be trivially copyable");
+		static_assert(sizeof(Quaternion) == sizeof(float) * 4, "Quaternion must be tightly packed");
+
 		std::ostream& operator<<(std::ostream& o, const Quaternion& q) {
 			o << q.x; o << ",";
 			o << q.y; o << ",";
@@ -16,7 +16,11 @@ namespace NCL {
 			SimpleFont(const std::string&fontName, const std::string&texName);
 			~SimpleFont();
 
-			int BuildVerticesForString(std::string &text, Maths::Vector2&startPos, Maths::Vector4&colour, std::vector<Maths::Vector3>&positions, std::vector<Maths::Vector2>&texCoords, std::vector<Maths::Vector4>&colours);
+			int BuildVerticesForString(const char* text, size_t length, const Maths::Vector2&startPos, const Maths::Vector4&colour, std::vector<Maths::Vector3>&positions, std::vector<Maths::Vector2>&texCoords, std::vector<Maths::Vector4>&colours);
+
+			int BuildVerticesForString(const std::string &text, const Maths::Vector2&startPos, const Maths::Vector4&colour, std::vector<Maths::Vector3>&positions, std::vector<Maths::Vector2>&texCoords, std::vector<Maths::Vector4>&colours) {
+				return BuildVerticesForString(text.c_str(), text.length(), startPos, colour, positions, texCoords, colours);
+			}
 
 			const TextureBase* GetTexture() const {
 				return texture;
@@ -14,22 +14,22 @@ _-_-_-_-_-_-_-""  ""
 *//////////////////////////////////////////////////////////////////////////////
 #pragma once
 #include <iostream>
+#include <type_traits>
 
 namespace NCL {
 	namespace Maths {
 		class Vector2 {
 
 		public:
-			Vector2(void) {
-				ToZero();
+			constexpr Vector2(void) : x(0.0f), y(0.0f) {
 			}
 
-			Vector2(const float x, const float y) {
-				this->x = x;
-				this->y = y;
+			constexpr Vector2(const float x, const float y) : x(x), y(y) {
 			}
 
-			~Vector2(void) {}
+			static constexpr Vector2 Zero() {
+				return Vector2(0.0f, 0.0f);
+			}
 
 			float x;
 			float y;
@@ -61,5 +61,9 @@ namespace NCL {
 				return Vector2(x / f, y / f);
 			};
 		};
+
+		//Gets memcpy'd straight into vertex buffers and packets
+		static_assert(std::is_trivially_copyable<Vector2>::value, "Vector2 must be trivially copyable");
+		static_assert(sizeof(Vector2) == sizeof(float) * 2, "Vector2 must be tightly packed");
 	}
 }
@@ -14,6 +14,7 @@ _-_-_-_-_-_-_-""  ""
 #include <cmath>
 #include <iostream>
 #include <algorithm>
+#include <type_traits>
 
 namespace NCL {
 	namespace Maths {
@@ -28,17 +29,15 @@ namespace NCL {
 				float array[3];
 			};
 		public:
-			Vector3(void) {
-				ToZero();
+			constexpr Vector3(void) : array{ 0.0f, 0.0f, 0.0f } {
 			}
 
-			Vector3(const float x, const float y, const float z) {
-				this->x = x;
-				this->y = y;
-				this->z = z;
+			constexpr Vector3(const float x, const float y, const float z) : array{ x, y, z } {
 			}
 
-			~Vector3(void) {}
+			static constexpr Vector3 Zero() {
+				return Vector3(0.0f, 0.0f, 0.0f);
+			}
 
 			Vector3 Normalised() const {
 				Vector3 temp(x, y, z);
@@ -188,5 +187,8 @@ namespace NCL {
 			inline bool	operator==(const Vector3 &A)const { return (A.x == x && A.y == y && A.z == z) ? true : false; };
 			inline bool	operator!=(const Vector3 &A)const { return (A.x == x && A.y == y && A.z == z) ? false : true; };
 		};
+
+		static_assert(std::is_trivially_copyable<Vector3>::value, "Vector3 must be trivially copyable");
+		static_assert(sizeof(Vector3) == sizeof(float) * 3, "Vector3 must be tightly packed");
 	}
 }
@@ -11,27 +11,26 @@ _-_-_-_-_-_-_-""  ""
 
 */
 #pragma once
+#include "Vector3.h"
+#include <type_traits>
 
 namespace NCL {
 	namespace Maths {
 		class Vector4 {
 		public:
-			Vector4(void) {
-				x = y = z = w = 1.0f;
+			constexpr Vector4(void) : x(1.0f), y(1.0f), z(1.0f), w(1.0f) {
 			}
-			Vector4(float x, float y, float z, float w) {
-				this->x = x;
-				this->y = y;
-				this->z = z;
-				this->w = w;
+			constexpr Vector4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {
+			}
+
+			static constexpr Vector4 Zero() {
+				return Vector4(0.0f, 0.0f, 0.0f, 0.0f);
 			}
 
 			inline Vector3 ToVector3() {
 				return Vector3(x, y, z);
 			}
 
-			~Vector4(void) {}
-
 			float x;
 			float y;
 			float z;
@@ -99,5 +98,8 @@ namespace NCL {
 				w -= f;
 			}
 		};
+
+		static_assert(std::is_trivially_copyable<Vector4>::value, "Vector4 must be trivially copyable");
+		static_assert(sizeof(Vector4) == sizeof(float) * 4, "Vector4 must be tightly packed");
 	}
 }
\ No newline at end of file
@@ -77,8 +77,29 @@ void OGLRenderer::RenderFrame()		{
 }
 
 void OGLRenderer::EndFrame()		{
-	DrawDebugData();
+	DrawDebugData(debugStrings, debugLines);
+	debugStrings.clear();
+	debugLines.clear();
+	debugText.Reset();
+	SwapBuffers();
+}
+
+void OGLRenderer::SwapBuffers() {
+#ifdef _WIN32
 	::SwapBuffers(deviceContext);
+#endif
+}
+
+void OGLRenderer::AttachContext() {
+#ifdef _WIN32
+	wglMakeCurrent(deviceContext, renderContext);
+#endif
+}
+
+void OGLRenderer::DetachContext() {
+#ifdef _WIN32
+	wglMakeCurrent(NULL, NULL);
+#endif
 }
 
 void OGLRenderer::BindShader(ShaderBase*s) {
@@ -167,6 +188,14 @@ void OGLRenderer::BindTextureToShader(const TextureBase*t, const std::string& un
 }
 
 void OGLRenderer::DrawString(const std::string& text, const Vector2&pos, const Vector4& colour) {
+	AddDebugString(text.c_str(), text.length(), pos, colour);
+}
+
+void OGLRenderer::DrawString(const char* text, const Vector2&pos, const Vector4& colour) {
+	AddDebugString(text, strlen(text), pos, colour);
+}
+
+void OGLRenderer::AddDebugString(const char* text, size_t length, const Vector2&pos, const Vector4& colour) {
 	DebugString s;
 	s.colour = colour;
 	s.ndcPos = (pos / Vector2((float)currentWidth, (float)currentHeight));
@@ -174,7 +203,11 @@ void OGLRenderer::DrawString(const std::string& text, const Vector2&pos, const V
 	s.ndcPos.x = (s.ndcPos.x * 2.0f) - 1.0f;
 	s.ndcPos.y = (s.ndcPos.y * 2.0f) - 1.0f;
 	s.size = 1.0f;
-	s.text = text;
+
+	char* copy = (char*)debugText.Allocate(length, 1); //the caller's string might not last the frame
+	memcpy(copy, text, length);
+	s.text		= copy;
+	s.length	= length;
 	debugStrings.emplace_back(s);
 }
 
@@ -186,7 +219,7 @@ void OGLRenderer::DrawLine(const Vector3& start, const Vector3& end, const Vecto
 	debugLines.emplace_back(l);
 }
 
-void OGLRenderer::DrawDebugData() {
+void OGLRenderer::DrawDebugData(const std::vector<DebugString>& strings, const std::vector<DebugLine>& lines) {
 	BindShader(debugShader);
 	glEnable(GL_BLEND);
 	glDisable(GL_DEPTH_TEST);
@@ -195,56 +228,45 @@ void OGLRenderer::DrawDebugData() {
 	int switchLocation = glGetUniformLocation(debugShader->GetProgramID(), "useMatrix");
 
 	glUniform1i(switchLocation, 0);
-	DrawDebugStrings();
+	DrawDebugStrings(strings);
 	SetupDebugMatrix(debugShader);
 	glUniform1i(switchLocation, 1);
-	DrawDebugLines();
+	DrawDebugLines(lines);
 
 	glDisable(GL_BLEND);
 	glEnable(GL_DEPTH_TEST);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
-void OGLRenderer::DrawDebugStrings() {
-	vector<Vector3> vertPos;
-	vector<Vector2> vertTex;
-	vector<Vector4> vertColours;
-
-	for (DebugString&s : debugStrings) {
-		font->BuildVerticesForString(s.text, s.ndcPos, s.colour, vertPos, vertTex, vertColours);
-	}
-
+void OGLRenderer::DrawDebugStrings(const std::vector<DebugString>& strings) {
 	OGLMesh textMesh = OGLMesh();
 
-	textMesh.SetVertexPositions(vertPos);
-	textMesh.SetVertexTextureCoords(vertTex);
-	textMesh.SetVertexColours(vertColours);
+	//Straight into the mesh, rather than building them up elsewhere and copying them in
+	for (const DebugString&s : strings) {
+		font->BuildVerticesForString(s.text, s.length, s.ndcPos, s.colour, textMesh.positions, textMesh.texCoords, textMesh.colours);
+	}
 
 	textMesh.UploadToGPU();
 
 	BindMesh(&textMesh);
 	BindTextureToShader(font->GetTexture(), "mainTex", 0);
 	DrawBoundMesh();
-
-	debugStrings.clear();
 }
 
-void OGLRenderer::DrawDebugLines() {
-	vector<Vector3> vertPos;
-	vector<Vector4> vertCol;
+void OGLRenderer::DrawDebugLines(const std::vector<DebugLine>& lines) {
+	OGLMesh lineMesh = OGLMesh();
 
-	for (DebugLine&s : debugLines) {
-		vertPos.emplace_back(s.start);
-		vertPos.emplace_back(s.end);
+	lineMesh.positions.reserve(lines.size() * 2);
+	lineMesh.colours.reserve(lines.size() * 2);
 
-		vertCol.emplace_back(s.colour);
-		vertCol.emplace_back(s.colour);
-	}
+	for (const DebugLine&s : lines) {
+		lineMesh.positions.emplace_back(s.start);
+		lineMesh.positions.emplace_back(s.end);
 
-	OGLMesh lineMesh = OGLMesh();
+		lineMesh.colours.emplace_back(s.colour);
+		lineMesh.colours.emplace_back(s.colour);
+	}
 
-	lineMesh.SetVertexPositions(vertPos);
-	lineMesh.SetVertexColours(vertCol);
 	lineMesh.SetPrimitiveType(GeometryPrimitive::Lines);
 
 	lineMesh.UploadToGPU();
@@ -252,8 +274,6 @@ void OGLRenderer::DrawDebugLines() {
 	BindMesh(&lineMesh);
 	BindTextureToShader(nullptr, "mainTex", 0);
 	DrawBoundMesh();
-
-	debugLines.clear();
 }
 
 #ifdef _WIN32
@@ -3,6 +3,7 @@
 
 #include "../../Common/Vector3.h"
 #include "../../Common/Vector4.h"
+#include "../../Common/FrameArena.h"
 
 
 #ifdef _WIN32
@@ -33,17 +34,39 @@ namespace NCL {
 			void OnWindowResize(int w, int h)	override;
 
 			void DrawString(const std::string& text, const Vector2&pos, const Vector4& colour = Vector4(0.75f, 0.75f, 0.75f,1));
+			void DrawString(const char* text, const Vector2&pos, const Vector4& colour = Vector4(0.75f, 0.75f, 0.75f,1));
 
 			void DrawLine(const Vector3& start, const Vector3& end, const Vector4& colour);
 
 		protected:			
+			struct DebugString {
+				Maths::Vector4 colour;
+				Maths::Vector2	ndcPos;
+				float			size;
+				const char*		text;	//in debugText, not null terminated
+				size_t			length;
+			};
+
+			struct DebugLine {
+				Maths::Vector3 start;
+				Maths::Vector3 end;
+				Maths::Vector4 colour;
+			};
+
 			void BeginFrame()	override;
 			void RenderFrame()	override;
 			void EndFrame()		override;
 
-			void DrawDebugData();
-			void DrawDebugStrings();
-			void DrawDebugLines();
+			void SwapBuffers();
+
+			//The context can only be current on one thread at a time - detach it
+			//from this one before attaching it to another
+			void AttachContext();
+			void DetachContext();
+
+			void DrawDebugData(const std::vector<DebugString>& strings, const std::vector<DebugLine>& lines);
+			void DrawDebugStrings(const std::vector<DebugString>& strings);
+			void DrawDebugLines(const std::vector<DebugLine>& lines);
 			virtual void SetupDebugMatrix(OGLShader*s) {
 			}
 
@@ -57,27 +80,19 @@ namespace NCL {
 			HDC		deviceContext;		//...Device context?
 			HGLRC	renderContext;		//Permanent Rendering Context
 #endif
-		private:
-			struct DebugString {
-				Maths::Vector4 colour;
-				Maths::Vector2	ndcPos;
-				float			size;
-				std::string		text;
-			};
+			void AddDebugString(const char* text, size_t length, const Vector2&pos, const Vector4& colour);
 
-			struct DebugLine {
-				Maths::Vector3 start;
-				Maths::Vector3 end;
-				Maths::Vector4 colour;
-			};
+			//What DrawString and DrawLine have added since the last frame
+			std::vector<DebugString>	debugStrings;
+			std::vector<DebugLine>		debugLines;
+			FrameArena					debugText;
 
+		private:
 			OGLMesh*	boundMesh;
 			OGLShader*	boundShader;
 
 			OGLShader*  debugShader;
 			SimpleFont* font;
-			std::vector<DebugString>	debugStrings;
-			std::vector<DebugLine>		debugLines;
 		};
 	}
 }
\ No newline at end of file